@@ -0,0 +1,59 @@
+#include <iostream>
+#include <skiplist.hpp>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <vector>
+
+// every trip to the global heap goes through here
+static long allocations = 0;
+
+void *operator new(std::size_t size) {
+  ++allocations;
+  if (void *ptr = std::malloc(size ? size : 1))
+    return ptr;
+  throw std::bad_alloc();
+}
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+// run op on every key, report heap allocations per call
+template <typename Op>
+void measure(const char *name, const std::vector<int> &keys, Op op) {
+  long before = allocations;
+  for (int k : keys)
+    op(k);
+  std::cout << name << ": " << double(allocations - before) / keys.size()
+            << " allocations/op" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+
+  if (argc < 2) {
+    std::cout <<
+      "Usage: ./alloc_benchmark size-of-list" <<
+      std::endl;
+    return 1;
+  }
+  const int size = atoi(argv[1]);
+  std::cout << "Size set to: " << size << std::endl;
+
+  std::vector<int> keys(size);
+  std::mt19937 generator(42);
+  for (int i = 0; i < size; ++i)
+    keys[i] = generator();
+
+  skiplist<int> list;
+  measure("Insert (new key)", keys, [&](int k) { list.insert(k); });
+  measure("Insert (duplicate)", keys, [&](int k) { list.insert(k); });
+  measure("Find", keys, [&](int k) { list.find(k); });
+  measure("Count", keys, [&](int k) { list.count(k); });
+  measure("Erase (duplicate)", keys, [&](int k) { list.erase(k); });
+  measure("Erase (last copy)", keys, [&](int k) { list.erase(k); });
+  // the pool hands back erased towers, no new slabs needed
+  measure("Insert (after erase)", keys, [&](int k) { list.insert(k); });
+
+  SLPoolStats stats = list.pool_stats();
+  std::cout << "Pool: " << stats.slabs << " slabs, " << stats.bytes
+            << " bytes, " << stats.free_nodes << " free towers" << std::endl;
+}
@@ -0,0 +1,64 @@
+#include <iostream>
+#include <skiplist.hpp>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+// applies every batch to a list of the given keys, returns ns per batch element
+template <typename Apply>
+double apply(const std::vector<int> &keys, const std::vector<std::vector<int>> &batches, Apply how) {
+  skiplist<int> list(sl_from_sorted, keys.begin(), keys.end());
+  size_t elements = 0;
+  auto t1 = std::chrono::high_resolution_clock::now();
+  for (const std::vector<int> &batch : batches) {
+    how(list, batch);
+    elements += batch.size();
+  }
+  auto t2 = std::chrono::high_resolution_clock::now();
+  std::cerr << "size " << list.size() << "\n";
+
+  std::chrono::duration<double, std::nano> time_taken = t2 - t1;
+  return time_taken.count() / elements;
+}
+
+int main(int argc, char *argv[]) {
+  int size = 1000000;
+  int batch = 10000;
+  if (argc > 1) {
+    size = atoi(argv[1]);
+  }
+  if (argc > 2) {
+    batch = atoi(argv[2]);
+  }
+  std::cout << "Size set to: " << size << std::endl;
+  std::cout << "Batch set to: " << batch << std::endl;
+
+  // even keys in the list, batches of random odd ones in no order
+  std::mt19937 generator(42);
+  std::vector<int> keys(size);
+  for (int i = 0; i < size; i++)
+    keys[i] = 2 * i;
+  std::vector<std::vector<int>> batches(std::max(1, size / 10 / batch), std::vector<int>(batch));
+  for (std::vector<int> &b : batches)
+    for (int &v : b)
+      v = 2 * (generator() % size) + 1;
+
+  std::cout << "Insert one by one: " << apply(keys, batches, [](skiplist<int> &list, const std::vector<int> &b) {
+    for (int v : b)
+      list.insert(v);
+  }) << " ns" << std::endl;
+  std::cout << "insert_batch: " << apply(keys, batches, [](skiplist<int> &list, const std::vector<int> &b) {
+    list.insert_batch(b.begin(), b.end());
+  }) << " ns" << std::endl;
+  std::cout << "Erase one by one: " << apply(keys, batches, [](skiplist<int> &list, const std::vector<int> &b) {
+    for (int v : b)
+      list.erase(v - 1);
+  }) << " ns" << std::endl;
+  std::cout << "erase_batch: " << apply(keys, batches, [](skiplist<int> &list, const std::vector<int> &b) {
+    std::vector<int> even(b);
+    for (int &v : even)
+      v -= 1;
+    list.erase_batch(even.begin(), even.end());
+  }) << " ns" << std::endl;
+}
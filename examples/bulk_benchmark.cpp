@@ -0,0 +1,55 @@
+#include <iostream>
+#include <skiplist.hpp>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+// builds a list out of sorted input the given way, returns ns per element
+template <typename Build>
+double build(const std::vector<int> &input, Build how) {
+  auto t1 = std::chrono::high_resolution_clock::now();
+  skiplist<int> list = how(input);
+  auto t2 = std::chrono::high_resolution_clock::now();
+  std::cerr << "size " << list.size() << "\n";
+
+  std::chrono::duration<double, std::nano> time_taken = t2 - t1;
+  return time_taken.count() / input.size();
+}
+
+int main(int argc, char *argv[]) {
+  int size = 4000000;
+  if (argc > 1) {
+    size = atoi(argv[1]);
+  }
+  std::cout << "Size set to: " << size << std::endl;
+
+  // sorted, with a duplicate every now and then
+  std::mt19937 generator(42);
+  std::vector<int> input(size);
+  for (int &v : input)
+    v = generator() % (size * 4);
+  std::sort(input.begin(), input.end());
+
+  std::cout << "Insert one by one: " << build(input, [](const std::vector<int> &in) {
+    skiplist<int> list;
+    for (int v : in)
+      list.insert(v);
+    return list;
+  }) << " ns" << std::endl;
+  std::cout << "Insert with end() as hint: " << build(input, [](const std::vector<int> &in) {
+    skiplist<int> list;
+    for (int v : in)
+      list.insert(list.end(), v);
+    return list;
+  }) << " ns" << std::endl;
+  std::cout << "Range constructor: " << build(input, [](const std::vector<int> &in) {
+    return skiplist<int>(in.begin(), in.end());
+  }) << " ns" << std::endl;
+  std::cout << "sl_from_sorted: " << build(input, [](const std::vector<int> &in) {
+    return skiplist<int>(sl_from_sorted, in.begin(), in.end());
+  }) << " ns" << std::endl;
+  std::cout << "sl_from_sorted_ideal: " << build(input, [](const std::vector<int> &in) {
+    return skiplist<int>(sl_from_sorted_ideal, in.begin(), in.end());
+  }) << " ns" << std::endl;
+}
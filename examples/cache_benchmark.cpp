@@ -0,0 +1,50 @@
+#include <iostream>
+#include <skiplist.hpp>
+#include <chrono>
+#include <random>
+#include <vector>
+
+// same list, with and without keys cached in the forward links
+using plain_list = skiplist<int, std::less<int>, SLHalfLevels<>, std::allocator<int>, false>;
+using cached_list = skiplist<int, std::less<int>, SLHalfLevels<>, std::allocator<int>, true>;
+
+template <typename List>
+double lookups(const std::vector<int> &keys, const std::vector<int> &probes) {
+  List list;
+  for (int k : keys)
+    list.insert(k);
+
+  long found = 0;
+  auto t1 = std::chrono::high_resolution_clock::now();
+  for (int p : probes)
+    found += list.find(p) != list.end();
+  auto t2 = std::chrono::high_resolution_clock::now();
+  std::cerr << "found " << found << "\n";
+
+  std::chrono::duration<double, std::nano> time_taken = t2 - t1;
+  return time_taken.count() / probes.size();
+}
+
+int main(int argc, char *argv[]) {
+  // big enough to spill out of the last level cache by default
+  int size = 4000000;
+  int iterations = 1000000;
+  if (argc > 1) {
+    size = atoi(argv[1]);
+  }
+  if (argc > 2) {
+    iterations = atoi(argv[2]);
+  }
+  std::cout << "Size set to: " << size << std::endl;
+  std::cout << "Iterations set to: " << iterations << std::endl;
+
+  std::mt19937 generator(42);
+  std::vector<int> keys(size), probes(iterations);
+  for (int &k : keys)
+    k = generator();
+  for (int &p : probes)
+    p = keys[generator() % size];
+
+  std::cout << "Find (plain links): " << lookups<plain_list>(keys, probes) << " ns" << std::endl;
+  std::cout << "Find (cached keys): " << lookups<cached_list>(keys, probes) << " ns" << std::endl;
+}
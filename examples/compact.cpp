@@ -0,0 +1,103 @@
+#include <iostream>
+#include <cassert>
+#include <random>
+#include <set>
+#include <string>
+#include <compact_skiplist.hpp>
+#include "multiset_check.hpp"
+
+// Tens of thousands of nodes, so the node arrays and the link array get
+// reallocated many times over with every id and link index still
+// pointing at the right place. Erased ids and towers go on the free
+// chains and are handed out again by the inserts that follow
+void arenas(std::mt19937 &generator) {
+    compact_skiplist<entry> list;
+    std::multiset<entry> expected;
+    int id = 0;
+    for(int round = 0; round < 4; round++) {
+        for(int i=0; i<20000; i++) {
+            entry e = {int(generator() % 3000), id++};
+            list.insert(e);
+            expected.insert(e);
+        }
+        same(list, expected);
+        for(int i=0; i<15000; i++) {
+            entry e = {int(generator() % 3000), 0};
+            list.erase(e);
+            erase_newest(expected, e);
+        }
+        same(list, expected);
+        for(int k=0; k<3000; k += 7) {
+            entry e = {k, 0};
+            assert(list.count(e) == expected.count(e));
+            auto found = list.find(e);
+            assert(found == list.end() ? !expected.count(e) : *found == *expected.find(e));
+        }
+    }
+
+    // erase by iterator, runs of equal keys at a time
+    while(list.size()) {
+        entry e = *list.begin();
+        auto it = list.find(e);
+        auto eit = expected.find(e);
+        while(it != list.end() && !(e < *it)) {
+            it = list.erase(it);
+            eit = expected.erase(eit);
+            assert(it == list.end() ? eit == expected.end() : *it == *eit);
+        }
+    }
+    same(list, expected);
+
+    // everything comes off the free chains now
+    for(int i=0; i<20000; i++) {
+        entry e = {int(generator() % 100000), id++};
+        list.insert(e);
+        expected.insert(e);
+    }
+    same(list, expected);
+}
+
+// copies carry the free chains along, and keep working on their own
+void copies(std::mt19937 &generator) {
+    compact_skiplist<std::string> list;
+    std::multiset<std::string> expected;
+    for(int i=0; i<20000; i++) {
+        std::string value = std::to_string(generator() % 8000);
+        list.insert(value);
+        expected.insert(value);
+        if(i % 2) {
+            value = std::to_string(generator() % 8000);
+            list.erase(value);
+            erase_newest(expected, value);
+        }
+    }
+    same(list, expected);
+
+    compact_skiplist<std::string> copy(list);
+    std::multiset<std::string> copied(expected);
+    for(int i=0; i<5000; i++) {
+        std::string value = std::to_string(generator() % 8000);
+        copy.insert(value);
+        copied.insert(value);
+        value = std::to_string(generator() % 8000);
+        list.erase(value);
+        erase_newest(expected, value);
+    }
+    same(list, expected);
+    same(copy, copied);
+
+    compact_skiplist<std::string> moved(std::move(copy));
+    same(moved, copied);
+    assert(copy.size() == 0 && copy.begin() == copy.end());
+    copy = list;
+    list = std::move(moved);
+    same(copy, expected);
+    same(list, copied);
+}
+
+int main() {
+    std::mt19937 generator(42);
+    arenas(generator);
+    copies(generator);
+    std::cout << "compact_skiplist matches std::multiset" << std::endl;
+}
@@ -0,0 +1,88 @@
+#include <iostream>
+#include <skiplist.hpp>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+// every comparison goes through here, so they can be counted
+static long comparisons = 0;
+
+// the usual less-than
+struct string_less {
+  bool operator()(const std::string &a, const std::string &b) const {
+    ++comparisons;
+    return a < b;
+  }
+};
+
+// same order, but one call tells less, equal and greater apart
+struct string_three_way {
+  using is_three_way = void;
+  int operator()(const std::string &a, const std::string &b) const {
+    ++comparisons;
+    return a.compare(b);
+  }
+};
+
+// keys share a long prefix, so every comparison has to walk past it
+std::string make_key(const std::string &prefix, unsigned id) {
+  std::string digits = std::to_string(id);
+  return prefix + std::string(10 - digits.size(), '0') + digits;
+}
+
+template <typename Compare>
+void run(const char *name, const std::vector<std::string> &keys,
+         const std::vector<std::string> &probes) {
+  skiplist<std::string, Compare> list;
+  comparisons = 0;
+  auto t1 = std::chrono::high_resolution_clock::now();
+  for (const std::string &k : keys)
+    list.insert(k);
+  auto t2 = std::chrono::high_resolution_clock::now();
+  long insert_comparisons = comparisons;
+
+  comparisons = 0;
+  long found = 0;
+  auto t3 = std::chrono::high_resolution_clock::now();
+  for (const std::string &p : probes)
+    found += list.find(p) != list.end();
+  auto t4 = std::chrono::high_resolution_clock::now();
+  std::cerr << "found " << found << "\n";
+
+  std::chrono::duration<double, std::nano> insert_time = t2 - t1, find_time = t4 - t3;
+  std::cout << name << ": insert " << insert_time.count() / keys.size() << " ns, "
+            << (double)insert_comparisons / keys.size() << " comparisons; find "
+            << find_time.count() / probes.size() << " ns, "
+            << (double)comparisons / probes.size() << " comparisons" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  int size = 200000;
+  int iterations = 1000000;
+  int prefix = 64;
+  if (argc > 1) {
+    size = atoi(argv[1]);
+  }
+  if (argc > 2) {
+    iterations = atoi(argv[2]);
+  }
+  if (argc > 3) {
+    prefix = atoi(argv[3]);
+  }
+  std::cout << "Size set to: " << size << std::endl;
+  std::cout << "Iterations set to: " << iterations << std::endl;
+  std::cout << "Common prefix set to: " << prefix << " bytes" << std::endl;
+
+  std::mt19937 generator(42);
+  std::string common(prefix, 'k');
+  std::vector<std::string> keys(size), probes(iterations);
+  for (std::string &k : keys)
+    k = make_key(common, generator());
+  // half of the probes are there, half are not
+  for (std::string &p : probes)
+    p = generator() % 2 ? keys[generator() % size] : make_key(common, generator());
+
+  run<string_less>("less-than", keys, probes);
+  run<string_three_way>("three-way", keys, probes);
+}
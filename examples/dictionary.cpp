@@ -12,18 +12,35 @@ public:
   DictKey(int key) : key_(key), value_("") {}
   DictKey(int key, std::string value) : key_(key), value_(value) {}
   friend bool operator<(const DictKey &, const DictKey &);
+  friend struct DictLess;
   friend std::ostream &operator<<(std::ostream &out, const DictKey &o);
 };
 
 bool operator<(const DictKey &left, const DictKey &right) {
   return left.key_ < right.key_;
 }
+
+// compares keys with each other and with plain ints.
+// is_transparent lets find and count take an int as is,
+// instead of building a DictKey (and its string) for every lookup
+struct DictLess {
+  using is_transparent = void;
+  bool operator()(const DictKey &left, const DictKey &right) const {
+    return left.key_ < right.key_;
+  }
+  bool operator()(const DictKey &left, int right) const {
+    return left.key_ < right;
+  }
+  bool operator()(int left, const DictKey &right) const {
+    return left < right.key_;
+  }
+};
 std::ostream &operator<<(std::ostream &out, const DictKey &o) {
   return out << "<" << o.key_ << ": " << o.value_ << ">";
 }
 
-void foundit(skiplist<DictKey> &s, DictKey x) {
-  skiplist<DictKey>::iterator itr = s.find(x);
+void foundit(skiplist<DictKey, DictLess> &s, int x) {
+  skiplist<DictKey, DictLess>::iterator itr = s.find(x);
   if (itr != std::end(s))
     std::cout << "Value: " << itr.node->val << " Count: " << itr.node->count
          << std::endl;
@@ -32,7 +49,7 @@ void foundit(skiplist<DictKey> &s, DictKey x) {
 }
 
 int main() {
-  skiplist<DictKey> aDict;
+  skiplist<DictKey, DictLess> aDict;
 
   aDict.insert({10, "hello"});
   aDict.insert({20, "jello"});
@@ -41,15 +58,15 @@ int main() {
 
   std::cout << aDict;
 
-  // foundit(aDict, DictKey{10});
-  // foundit(aDict, DictKey{20});
-  // foundit(aDict, DictKey{30});
+  foundit(aDict, 10);
+  foundit(aDict, 20);
+  foundit(aDict, 30);
   std::cout << "SKIPLIST:\n";
   for(auto e: aDict)
     std::cout << e << "\n";
 
   // same operations on multiset
-  std::multiset<DictKey> lolz;
+  std::multiset<DictKey, DictLess> lolz;
   lolz.insert({10, "hello"});
   lolz.insert({20, "jello"});
   lolz.insert({20, "yello"});
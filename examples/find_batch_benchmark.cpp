@@ -0,0 +1,58 @@
+#include <iostream>
+#include <skiplist.hpp>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+// finds every probe one at a time or with find_batch, returns ns per probe
+template <typename T>
+double lookups(const std::vector<T> &keys, const std::vector<T> &probes, bool batched) {
+  skiplist<T> list(keys.begin(), keys.end());
+  std::vector<typename skiplist<T>::iterator> found(probes.size(), list.end());
+
+  auto t1 = std::chrono::high_resolution_clock::now();
+  if (batched)
+    list.find_batch(probes.begin(), probes.end(), found.begin());
+  else
+    for (size_t i = 0; i < probes.size(); i++)
+      found[i] = list.find(probes[i]);
+  auto t2 = std::chrono::high_resolution_clock::now();
+  long hits = 0;
+  for (auto &it : found)
+    hits += it != list.end();
+  std::cerr << "found " << hits << "\n";
+
+  std::chrono::duration<double, std::nano> time_taken = t2 - t1;
+  return time_taken.count() / probes.size();
+}
+
+int main(int argc, char *argv[]) {
+  int size = 4000000;
+  int iterations = 1000000;
+  if (argc > 1) {
+    size = atoi(argv[1]);
+  }
+  if (argc > 2) {
+    iterations = atoi(argv[2]);
+  }
+  std::cout << "Size set to: " << size << std::endl;
+  std::cout << "Iterations set to: " << iterations << std::endl;
+
+  std::mt19937 generator(42);
+  std::vector<int> keys(size), probes(iterations);
+  for (int &k : keys)
+    k = generator();
+  for (int &p : probes)
+    p = keys[generator() % size];
+  std::vector<std::string> words(size), word_probes(iterations);
+  for (int i = 0; i < size; i++)
+    words[i] = std::to_string(keys[i]);
+  for (int i = 0; i < iterations; i++)
+    word_probes[i] = std::to_string(probes[i]);
+
+  std::cout << "find (int): " << lookups(keys, probes, false) << " ns" << std::endl;
+  std::cout << "find_batch (int): " << lookups(keys, probes, true) << " ns" << std::endl;
+  std::cout << "find (string): " << lookups(words, word_probes, false) << " ns" << std::endl;
+  std::cout << "find_batch (string): " << lookups(words, word_probes, true) << " ns" << std::endl;
+}
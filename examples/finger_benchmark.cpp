@@ -0,0 +1,55 @@
+#include <iostream>
+#include <skiplist.hpp>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+// inserts every key into an empty list, then finds every key again.
+// returns ns per insert and per find
+std::pair<double, double> run(const std::vector<int> &keys, bool finger) {
+  skiplist<int> list;
+  list.set_finger(finger);
+
+  auto t1 = std::chrono::high_resolution_clock::now();
+  for (int k : keys)
+    list.insert(k);
+  auto t2 = std::chrono::high_resolution_clock::now();
+  long found = 0;
+  for (int k : keys)
+    found += list.find(k) != list.end();
+  auto t3 = std::chrono::high_resolution_clock::now();
+  std::cerr << "found " << found << "\n";
+
+  std::chrono::duration<double, std::nano> inserts = t2 - t1, finds = t3 - t2;
+  return std::make_pair(inserts.count() / keys.size(), finds.count() / keys.size());
+}
+
+void report(const std::string &name, const std::vector<int> &keys) {
+  std::pair<double, double> plain = run(keys, false), finger = run(keys, true);
+  std::cout << name << ": insert " << plain.first << " ns, with finger " << finger.first << " ns; find "
+            << plain.second << " ns, with finger " << finger.second << " ns" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  int size = 1000000;
+  if (argc > 1) {
+    size = atoi(argv[1]);
+  }
+  std::cout << "Size set to: " << size << std::endl;
+
+  std::mt19937 generator(42);
+  std::vector<int> sequential(size), clustered(size), random(size);
+  // a walk that mostly stays within a few dozen keys of where it was
+  int at = 0;
+  for (int i = 0; i < size; i++) {
+    sequential[i] = i;
+    at += (int)(generator() % 64) - 31;
+    clustered[i] = at;
+    random[i] = generator();
+  }
+
+  report("Sequential", sequential);
+  report("Clustered", clustered);
+  report("Random", random);
+}
@@ -0,0 +1,52 @@
+#include <iostream>
+#include <skiplist.hpp>
+#include <chrono>
+#include <functional>
+#include <random>
+#include <vector>
+
+// a comparator SLDenseIndex does not know about, so no index
+struct unindexed_less : std::less<int> {};
+
+using indexed_list = skiplist<int>;
+using plain_list = skiplist<int, unindexed_less>;
+
+template <typename List>
+double lookups(const std::vector<int> &keys, const std::vector<int> &probes) {
+  List list;
+  for (int k : keys)
+    list.insert(k);
+
+  long found = 0;
+  auto t1 = std::chrono::high_resolution_clock::now();
+  for (int p : probes)
+    found += list.find(p) != list.end();
+  auto t2 = std::chrono::high_resolution_clock::now();
+  std::cerr << "found " << found << "\n";
+
+  std::chrono::duration<double, std::nano> time_taken = t2 - t1;
+  return time_taken.count() / probes.size();
+}
+
+int main(int argc, char *argv[]) {
+  int size = 1000000;
+  int iterations = 1000000;
+  if (argc > 1) {
+    size = atoi(argv[1]);
+  }
+  if (argc > 2) {
+    iterations = atoi(argv[2]);
+  }
+  std::cout << "Size set to: " << size << std::endl;
+  std::cout << "Iterations set to: " << iterations << std::endl;
+
+  std::mt19937 generator(42);
+  std::vector<int> keys(size), probes(iterations);
+  for (int &k : keys)
+    k = generator();
+  for (int &p : probes)
+    p = keys[generator() % size];
+
+  std::cout << "Find (no index): " << lookups<plain_list>(keys, probes) << " ns" << std::endl;
+  std::cout << "Find (top level index): " << lookups<indexed_list>(keys, probes) << " ns" << std::endl;
+}
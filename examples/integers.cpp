@@ -0,0 +1,84 @@
+#include <iostream>
+#include <cassert>
+#include <climits>
+#include <cstdint>
+#include <random>
+#include <set>
+#include <vector>
+#include <int_skiplist.hpp>
+#include "multiset_check.hpp"
+
+// Keys drawn from pick, inserted and erased at random in a list with
+// blocks of Bytes, checked against std::multiset as it goes.
+// Every block holds many keys, so this decodes across block boundaries
+template<typename T, int Bytes, typename Pick>
+void mirror(std::mt19937 &generator, int n, Pick pick) {
+    int_skiplist<T, SLHalfLevels<>, std::allocator<T>, Bytes> list;
+    std::multiset<T> expected;
+    std::vector<T> seen;
+    for(int i=0; i<n; i++) {
+        T value = pick(generator);
+        list.insert(value);
+        expected.insert(value);
+        seen.push_back(value);
+    }
+    same(list, expected);
+    for(int i=0; i<n / 4; i++) {
+        T value = seen[generator() % seen.size()];
+        assert(list.count(value) == (int)expected.count(value));
+        assert(list.find(value) != list.end() && *list.find(value) == value);
+        T missing = pick(generator);
+        assert((list.find(missing) != list.end()) == (expected.count(missing) > 0));
+    }
+
+    // erase half by value, so blocks drop under a quarter and get joined
+    for(int i=0; i<n / 2; i++) {
+        T value = seen[generator() % seen.size()];
+        list.erase(value);
+        auto it = expected.find(value);
+        if(it != expected.end())
+            expected.erase(it);
+    }
+    same(list, expected);
+
+    // then the rest by iterator, every third key first
+    auto it = list.begin();
+    auto eit = expected.begin();
+    for(int i=0; it != list.end(); i++) {
+        if(i % 3) {
+            ++it;
+            ++eit;
+            continue;
+        }
+        it = list.erase(it);
+        eit = expected.erase(eit);
+        assert(it == list.end() ? eit == expected.end() : *it == *eit);
+    }
+    same(list, expected);
+    int_skiplist<T, SLHalfLevels<>, std::allocator<T>, Bytes> copy(list);
+    while(list.begin() != list.end())
+        list.erase(list.begin());
+    assert(list.size() == 0);
+    same(copy, expected);
+}
+
+int main() {
+    std::mt19937 generator(42);
+    // dense ids, a byte per difference and runs of equal keys
+    mirror<int, 256>(generator, 20000, [](std::mt19937 &g) { return int(g() % 10000); });
+    // the same in the smallest blocks, which split and join all the time
+    mirror<int, 64>(generator, 20000, [](std::mt19937 &g) { return int(g() % 10000); });
+    // negative keys, and gaps of up to five bytes across the whole range
+    mirror<int, 256>(generator, 20000, [](std::mt19937 &g) { return int(g()); });
+    mirror<int, 64>(generator, 5000, [](std::mt19937 &g) {
+        int extremes[] = {INT_MIN, INT_MIN + 1, -1, 0, 1, INT_MAX - 1, INT_MAX};
+        return g() % 2 ? extremes[g() % 7] : int(g());
+    });
+    // 64-bit keys, where a gap takes up to ten bytes
+    mirror<std::int64_t, 256>(generator, 20000, [](std::mt19937 &g) {
+        std::int64_t value = (std::int64_t)(((std::uint64_t)g() << 32) | g());
+        return g() % 4 ? value : value % 1000;
+    });
+    mirror<unsigned, 128>(generator, 20000, [](std::mt19937 &g) { return unsigned(g()) | (g() % 2 ? 0x80000000u : 0u); });
+    std::cout << "int_skiplist matches std::multiset" << std::endl;
+}
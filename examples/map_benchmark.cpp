@@ -0,0 +1,99 @@
+#include <iostream>
+#include <skiplist_map.hpp>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <random>
+#include <vector>
+
+// a value big enough to push keys apart if it sat next to them
+struct payload {
+  char bytes[256];
+};
+
+template <typename Map>
+double lookups(const std::vector<int> &keys, const std::vector<int> &probes) {
+  Map map;
+  for (int k : keys)
+    map.insert({k, typename Map::mapped_type()});
+
+  long found = 0;
+  auto t1 = std::chrono::high_resolution_clock::now();
+  for (int p : probes)
+    found += map.find(p) != map.end();
+  auto t2 = std::chrono::high_resolution_clock::now();
+  std::cerr << "found " << found << "\n";
+
+  std::chrono::duration<double, std::nano> time_taken = t2 - t1;
+  return time_taken.count() / probes.size();
+}
+
+template <typename V>
+double skiplist_lookups(const std::vector<int> &keys, const std::vector<int> &probes) {
+  skiplist<int, V> map;
+  for (int k : keys)
+    map.insert(k, V());
+
+  long found = 0;
+  auto t1 = std::chrono::high_resolution_clock::now();
+  for (int p : probes)
+    found += map.find(p) != map.end();
+  auto t2 = std::chrono::high_resolution_clock::now();
+  std::cerr << "found " << found << "\n";
+
+  std::chrono::duration<double, std::nano> time_taken = t2 - t1;
+  return time_taken.count() / probes.size();
+}
+
+// ns per key to build a map out of sorted keys, with insert
+// one by one or with end() as the hint
+template <typename Map>
+double sorted_inserts(const std::vector<int> &sorted, bool hint) {
+  auto t1 = std::chrono::high_resolution_clock::now();
+  Map map;
+  for (int k : sorted) {
+    if (hint)
+      map.emplace_hint(map.end(), k, 0);
+    else
+      map.emplace(k, 0);
+  }
+  auto t2 = std::chrono::high_resolution_clock::now();
+  std::cerr << "built " << map.size() << "\n";
+
+  std::chrono::duration<double, std::nano> time_taken = t2 - t1;
+  return time_taken.count() / sorted.size();
+}
+
+int main(int argc, char *argv[]) {
+  int size = 1000000;
+  int iterations = 1000000;
+  if (argc > 1) {
+    size = atoi(argv[1]);
+  }
+  if (argc > 2) {
+    iterations = atoi(argv[2]);
+  }
+  std::cout << "Size set to: " << size << std::endl;
+  std::cout << "Iterations set to: " << iterations << std::endl;
+
+  std::mt19937 generator(42);
+  std::vector<int> keys(size), probes(iterations);
+  for (int &k : keys)
+    k = generator();
+  for (int &p : probes)
+    p = keys[generator() % size];
+
+  // the values stay out of the way of the search, so the size of
+  // the value should barely show up in a skiplist lookup
+  std::cout << "Find (skiplist, int values): " << skiplist_lookups<int>(keys, probes) << " ns" << std::endl;
+  std::cout << "Find (skiplist, 256 byte values): " << skiplist_lookups<payload>(keys, probes) << " ns" << std::endl;
+  std::cout << "Find (std::multimap, int values): " << lookups<std::multimap<int, int>>(keys, probes) << " ns" << std::endl;
+  std::cout << "Find (std::multimap, 256 byte values): " << lookups<std::multimap<int, payload>>(keys, probes) << " ns" << std::endl;
+
+  // keys that only grow, like timestamps: each goes past the last one
+  std::vector<int> sorted(keys);
+  std::sort(sorted.begin(), sorted.end());
+  std::cout << "Insert sorted (skiplist): " << sorted_inserts<skiplist<int, int>>(sorted, false) << " ns" << std::endl;
+  std::cout << "Insert sorted (skiplist, end() as hint): " << sorted_inserts<skiplist<int, int>>(sorted, true) << " ns" << std::endl;
+  std::cout << "Insert sorted (std::multimap, end() as hint): " << sorted_inserts<std::multimap<int, int>>(sorted, true) << " ns" << std::endl;
+}
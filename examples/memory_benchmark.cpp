@@ -0,0 +1,62 @@
+#include <iostream>
+#include <skiplist.hpp>
+#include <unrolled_skiplist.hpp>
+#include <int_skiplist.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <set>
+#include <vector>
+
+// every byte asked of the global heap goes through here
+static long long allocated = 0;
+
+void *operator new(std::size_t size) {
+  allocated += size;
+  if (void *ptr = std::malloc(size ? size : 1))
+    return ptr;
+  throw std::bad_alloc();
+}
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+// heap bytes per key for a container holding keys, inserted one by one.
+// nothing is erased, so what was allocated is what is held
+template <typename Set>
+double footprint(const std::vector<int> &keys) {
+  long long before = allocated;
+  Set *set = new Set;
+  for (int k : keys)
+    set->insert(k);
+  double bytes = double(allocated - before) / keys.size();
+  delete set;
+  return bytes;
+}
+
+int main(int argc, char *argv[]) {
+
+  if (argc < 3) {
+    std::cout <<
+      "Usage: ./memory_benchmark size-of-list average-gap-between-keys" <<
+      std::endl;
+    return 1;
+  }
+  const int size = atoi(argv[1]);
+  const int gap = atoi(argv[2]);
+  std::cout << "Size set to: " << size << std::endl;
+  std::cout << "Gap set to: " << gap << std::endl;
+
+  // a sorted set of ids, shuffled
+  std::vector<int> keys(size);
+  std::mt19937 generator(42);
+  int id = 0;
+  for (int &k : keys)
+    k = id += 1 + generator() % (2 * gap);
+  std::shuffle(keys.begin(), keys.end(), generator);
+
+  std::cout << "skiplist: " << footprint<skiplist<int> >(keys) << " bytes/key" << std::endl;
+  std::cout << "unrolled_skiplist: " << footprint<unrolled_skiplist<int> >(keys) << " bytes/key" << std::endl;
+  std::cout << "int_skiplist: " << footprint<int_skiplist<int> >(keys) << " bytes/key" << std::endl;
+  std::cout << "std::set: " << footprint<std::set<int> >(keys) << " bytes/key" << std::endl;
+}
@@ -0,0 +1,49 @@
+/*
+Helpers for the examples that check a container against std::multiset
+They run both through the same operations and assert they agree
+*/
+#ifndef MULTISET_CHECK_H
+#define MULTISET_CHECK_H
+
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <set>
+
+// Equal keys are told apart by id, so a check can see which of the
+// equal elements the list kept and in what order
+struct entry {
+    int key, id;
+    bool operator<(const entry &rhs) const { return key < rhs.key; }
+    bool operator==(const entry &rhs) const { return key == rhs.key && id == rhs.id; }
+};
+
+// same elements as the multiset, in the same order
+template<typename List, typename T>
+void same_forward(List &list, const std::multiset<T> &expected) {
+    assert((std::size_t)list.size() == expected.size());
+    auto it = expected.begin();
+    for(auto &&value : list)
+        assert(it != expected.end() && value == *it++);
+    assert(it == expected.end());
+}
+
+// and backwards too
+template<typename List, typename T>
+void same(List &list, const std::multiset<T> &expected) {
+    same_forward(list, expected);
+    auto rit = expected.rbegin();
+    for(auto r = list.rbegin(); r != list.rend(); ++r)
+        assert(*r == *rit++);
+}
+
+// The lists erase(value) the newest of the equal elements, the last of
+// them in a multiset
+template<typename T>
+void erase_newest(std::multiset<T> &set, const T &value) {
+    auto it = set.upper_bound(value);
+    if(it != set.begin() && !(*std::prev(it) < value))
+        set.erase(std::prev(it));
+}
+
+#endif
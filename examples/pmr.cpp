@@ -0,0 +1,24 @@
+#include <iostream>
+#include <memory_resource>
+#include <skiplist.hpp>
+
+// a short-lived skiplist living entirely in a stack buffer
+int main() {
+  char buffer[16 * 1024];
+  std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer));
+
+  pmr::skiplist<int> request_local(&arena);
+  for (int i = 0; i < 100; ++i)
+    request_local.insert(i % 10);
+  request_local.erase(3);
+
+  std::cout << "Size: " << request_local.size() << "\n";
+  std::cout << "Count of 4: " << request_local.count(4) << "\n";
+
+  SLPoolStats stats = request_local.pool_stats();
+  std::cout << "Pool: " << stats.slabs << " slabs, " << stats.bytes
+            << " bytes, all of it from the arena\n";
+
+  // nothing is freed one by one, the arena goes away with the buffer
+  return 0;
+}
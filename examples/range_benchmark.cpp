@@ -0,0 +1,51 @@
+#include <iostream>
+#include <skiplist.hpp>
+#include <chrono>
+#include <string>
+
+// a sliding window over time-ordered keys: every round appends batch new
+// timestamps and drops everything older than the last window of them.
+// returns ns per dropped element
+double run(int window, int batch, int rounds, bool by_range) {
+  skiplist<long> list;
+  long now = 0;
+  for (; now < window; now++)
+    list.insert(list.end(), now);
+
+  std::chrono::duration<double, std::nano> taken(0);
+  long dropped = 0;
+  for (int r = 0; r < rounds; r++) {
+    for (int i = 0; i < batch; i++, now++)
+      list.insert(list.end(), now);
+    auto t1 = std::chrono::high_resolution_clock::now();
+    int before = list.size();
+    if (by_range)
+      list.erase(list.begin(), list.lower_bound(now - window));
+    else
+      while (*list.begin() < now - window)
+        list.erase(list.begin());
+    auto t2 = std::chrono::high_resolution_clock::now();
+    dropped += before - list.size();
+    taken += t2 - t1;
+  }
+  std::cerr << "left " << list.size() << "\n";
+  return taken.count() / dropped;
+}
+
+int main(int argc, char *argv[]) {
+  int window = 1000000;
+  int rounds = 100;
+  if (argc > 1) {
+    window = atoi(argv[1]);
+  }
+  if (argc > 2) {
+    rounds = atoi(argv[2]);
+  }
+  std::cout << "Window set to: " << window << std::endl;
+  std::cout << "Rounds set to: " << rounds << std::endl;
+
+  for (int batch : {100, 10000, 100000}) {
+    std::cout << "Truncate " << batch << " (erase one at a time): " << run(window, batch, rounds, false) << " ns" << std::endl;
+    std::cout << "Truncate " << batch << " (erase(first, last)): " << run(window, batch, rounds, true) << " ns" << std::endl;
+  }
+}
@@ -0,0 +1,132 @@
+#include <iostream>
+#include <cassert>
+#include <iterator>
+#include <random>
+#include <set>
+#include <skiplist.hpp>
+#include "multiset_check.hpp"
+
+// the element at it, or that both are at the end
+template<typename It, typename Expected>
+bool same_at(It it, It end, Expected eit, Expected eend) {
+    return it == end ? eit == eend : eit != eend && *it == *eit;
+}
+
+// lower_bound, upper_bound, equal_range and range(lo, hi) over every key
+// in use and a few around them
+template<typename List>
+void bounds(List &list, const std::multiset<entry> &expected, int keys) {
+    for(int k=-1; k<=keys; k++) {
+        entry e = {k, 0};
+        assert(same_at(list.lower_bound(e), list.end(), expected.lower_bound(e), expected.end()));
+        assert(same_at(list.upper_bound(e), list.end(), expected.upper_bound(e), expected.end()));
+        auto found = list.equal_range(e);
+        auto wanted = expected.equal_range(e);
+        assert(same_at(found.first, list.end(), wanted.first, expected.end()));
+        assert(same_at(found.second, list.end(), wanted.second, expected.end()));
+        entry hi = {k + 3, 0};
+        auto eit = expected.lower_bound(e);
+        for(const entry &value : list.range(e, hi))
+            assert(eit != expected.end() && value == *eit++);
+        assert(eit == expected.lower_bound(hi));
+    }
+    // hi before lo is empty
+    entry lo = {keys / 2, 0}, hi = {keys / 4, 0};
+    assert(list.range(lo, hi).begin() == list.range(lo, hi).end());
+}
+
+// Long runs of equal keys, so most ranges start or end partway through
+// one: the copies before first and from last on have to stay, in order.
+// skiplist's reverse iterators go over the copies in a tower oldest
+// first, so only the forward order is compared
+void spans(std::mt19937 &generator) {
+    const int keys = 60;
+    skiplist<entry> list;
+    std::multiset<entry> expected;
+    int id = 0;
+    for(int round = 0; round < 20; round++) {
+        while(list.size() < 3000) {
+            entry e = {int(generator() % keys), id++};
+            list.insert(e);
+            expected.insert(e);
+        }
+        same_forward(list, expected);
+        bounds(list, expected, keys);
+        for(int i=0; i<100; i++) {
+            int size = list.size();
+            int from = generator() % (size + 1), to = generator() % (size + 1);
+            if(from > to)
+                std::swap(from, to);
+            // short ones mostly, inside a run or across a few
+            if(i % 4)
+                to = std::min(to, from + int(generator() % 80));
+            auto it = list.erase(std::next(list.begin(), from), std::next(list.begin(), to));
+            auto eit = expected.erase(std::next(expected.begin(), from), std::next(expected.begin(), to));
+            assert(same_at(it, list.end(), eit, expected.end()));
+        }
+        same_forward(list, expected);
+
+        // the middle of one run, both ends inside it
+        entry e = {int(generator() % keys), 0};
+        auto run = list.equal_range(e);
+        auto wanted = expected.equal_range(e);
+        if(std::distance(wanted.first, wanted.second) > 2) {
+            auto it = list.erase(std::next(run.first), std::prev(run.second));
+            auto eit = expected.erase(std::next(wanted.first), std::prev(wanted.second));
+            assert(same_at(it, list.end(), eit, expected.end()));
+        }
+
+        // nothing to erase
+        auto middle = std::next(list.begin(), list.size() / 2);
+        auto kept = list.erase(middle, middle);
+        assert(kept == middle);
+        same_forward(list, expected);
+
+        // erase_range(lo, hi) over whole keys
+        entry lo = {int(generator() % keys), 0}, hi = {lo.key + int(generator() % 5), 0};
+        int erased = list.erase_range(lo, hi);
+        auto first = expected.lower_bound(lo), last = expected.lower_bound(hi);
+        assert(erased == (int)std::distance(first, last));
+        expected.erase(first, last);
+        same_forward(list, expected);
+    }
+
+    // the whole list
+    assert(list.erase(list.begin(), list.end()) == list.end());
+    assert(list.size() == 0 && list.begin() == list.end());
+    expected.clear();
+    for(int i=0; i<1000; i++) {
+        entry e = {int(generator() % keys), id++};
+        list.insert(e);
+        expected.insert(e);
+    }
+    same_forward(list, expected);
+    bounds(list, expected, keys);
+}
+
+// With counted copies every equal element is the same, only how many
+// of them go matters
+void counted(std::mt19937 &generator) {
+    skiplist<int, std::less<int>, SLHalfLevels<>, std::allocator<int>, true, SLCountedDups> list;
+    std::multiset<int> expected;
+    for(int i=0; i<5000; i++) {
+        int value = generator() % 40;
+        list.insert(value);
+        expected.insert(value);
+    }
+    for(int i=0; i<200 && list.size(); i++) {
+        int size = list.size();
+        int from = generator() % size, to = std::min(size, from + int(generator() % 50));
+        auto it = list.erase(std::next(list.begin(), from), std::next(list.begin(), to));
+        auto eit = expected.erase(std::next(expected.begin(), from), std::next(expected.begin(), to));
+        assert(same_at(it, list.end(), eit, expected.end()));
+    }
+    same_forward(list, expected);
+}
+
+int main() {
+    std::mt19937 generator(42);
+    spans(generator);
+    counted(generator);
+    std::cout << "skiplist ranges match std::multiset" << std::endl;
+}
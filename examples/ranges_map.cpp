@@ -0,0 +1,117 @@
+#include <iostream>
+#include <cassert>
+#include <iterator>
+#include <map>
+#include <random>
+#include <skiplist_map.hpp>
+
+using map_t = skiplist<int, int>;
+using expected_t = std::multimap<int, int>;
+
+// the key and value at it, or that both are at the end.
+// Values are unique, so this tells equal keys apart
+bool same_at(map_t::iterator it, map_t &map, expected_t::iterator eit, expected_t &expected) {
+    if(it == map.end())
+        return eit == expected.end();
+    return eit != expected.end() && it.node->val == eit->first && *it == eit->second;
+}
+
+// same keys with the same values, in the same order
+void same(map_t &map, expected_t &expected) {
+    assert(map.size() == (int)expected.size());
+    auto eit = expected.begin();
+    for(auto it = map.begin(); it != map.end(); ++it)
+        assert(same_at(it, map, eit++, expected));
+    assert(eit == expected.end());
+}
+
+// Long runs of equal keys, so most ranges start or end partway through
+// one. The values the range does not cover have to stay, and in order
+void spans(std::mt19937 &generator) {
+    const int keys = 60;
+    map_t map;
+    expected_t expected;
+    int value = 0;
+    for(int round = 0; round < 20; round++) {
+        // filled through every way in: the right hint, end(), a wrong
+        // one (which falls back to a search) and no hint at all
+        while(map.size() < 3000) {
+            int key = generator() % keys;
+            map_t::iterator it = map.end();
+            switch(value % 4) {
+            case 0: it = map.emplace_hint(map.upper_bound(key), key, value); break;
+            case 1: it = map.emplace_hint(map.end(), key, value); break;
+            case 2: it = map.emplace_hint(map.begin(), key, value); break;
+            default: it = map.emplace(key, value);
+            }
+            assert(it.node->val == key && *it == value);
+            expected.insert(std::make_pair(key, value++));
+        }
+        same(map, expected);
+        for(int k=-1; k<=keys; k++) {
+            assert(same_at(map.lower_bound(k), map, expected.lower_bound(k), expected));
+            assert(same_at(map.upper_bound(k), map, expected.upper_bound(k), expected));
+            auto found = map.equal_range(k);
+            auto wanted = expected.equal_range(k);
+            assert(same_at(found.first, map, wanted.first, expected));
+            assert(same_at(found.second, map, wanted.second, expected));
+            auto eit = expected.lower_bound(k);
+            for(int mapped : map.range(k, k + 3))
+                assert(eit != expected.end() && mapped == (eit++)->second);
+            assert(eit == expected.lower_bound(k + 3));
+        }
+
+        for(int i=0; i<100; i++) {
+            int size = map.size();
+            int from = generator() % (size + 1), to = generator() % (size + 1);
+            if(from > to)
+                std::swap(from, to);
+            if(i % 4)
+                to = std::min(to, from + int(generator() % 80));
+            auto it = map.erase(std::next(map.begin(), from), std::next(map.begin(), to));
+            auto eit = expected.erase(std::next(expected.begin(), from), std::next(expected.begin(), to));
+            assert(same_at(it, map, eit, expected));
+        }
+        same(map, expected);
+
+        // nothing to erase
+        auto middle = std::next(map.begin(), map.size() / 2);
+        assert(map.erase(middle, middle) == middle);
+
+        int lo = generator() % keys, hi = lo + generator() % 5;
+        int erased = map.erase_range(lo, hi);
+        auto first = expected.lower_bound(lo), last = expected.lower_bound(hi);
+        assert(erased == (int)std::distance(first, last));
+        expected.erase(first, last);
+        same(map, expected);
+    }
+
+    // the whole map
+    assert(map.erase(map.begin(), map.end()) == map.end());
+    assert(map.size() == 0 && map.begin() == map.end());
+    expected.clear();
+    // then keys that never go down, so each is equal to the last one or
+    // goes past it, with gaps left in between
+    for(int key=0; key<30000; key += generator() % 3) {
+        map_t::iterator it = value % 2 ? map.emplace_hint(map.end(), key, value) : map.emplace(key, value);
+        assert(it.node->val == key && *it == value);
+        expected.insert(std::make_pair(key, value++));
+    }
+    same(map, expected);
+    // and the gaps filled in through the right hint, each a new tower
+    // linked in from the towers before it
+    for(int key=0; key<30000; key++) {
+        if(expected.count(key))
+            continue;
+        map_t::iterator it = map.emplace_hint(map.upper_bound(key), key, value);
+        assert(it.node->val == key && *it == value);
+        expected.insert(std::make_pair(key, value++));
+    }
+    same(map, expected);
+}
+
+int main() {
+    std::mt19937 generator(42);
+    spans(generator);
+    std::cout << "skiplist map ranges match std::multimap" << std::endl;
+}
@@ -0,0 +1,62 @@
+#include <iostream>
+#include <skiplist.hpp>
+#include <unrolled_skiplist.hpp>
+#include <chrono>
+#include <random>
+#include <set>
+#include <vector>
+
+// find each starting point, then walk `length` elements from it
+template <typename List>
+double scans(List &list, const std::vector<int> &starts, int length) {
+  long sum = 0;
+  auto t1 = std::chrono::high_resolution_clock::now();
+  for (int s : starts) {
+    auto it = list.find(s);
+    for (int i = 0; i < length && it != list.end(); ++i, ++it)
+      sum += *it;
+  }
+  auto t2 = std::chrono::high_resolution_clock::now();
+  std::cerr << "sum " << sum << "\n";
+
+  std::chrono::duration<double, std::nano> time_taken = t2 - t1;
+  return time_taken.count() / starts.size();
+}
+
+int main(int argc, char *argv[]) {
+  int size = 1000000;
+  int iterations = 10000;
+  int length = 1000;
+  if (argc > 1) {
+    size = atoi(argv[1]);
+  }
+  if (argc > 2) {
+    iterations = atoi(argv[2]);
+  }
+  if (argc > 3) {
+    length = atoi(argv[3]);
+  }
+  std::cout << "Size set to: " << size << std::endl;
+  std::cout << "Iterations set to: " << iterations << std::endl;
+  std::cout << "Scan length set to: " << length << std::endl;
+
+  std::mt19937 generator(42);
+  std::vector<int> keys(size), starts(iterations);
+  for (int &k : keys)
+    k = generator();
+  for (int &s : starts)
+    s = keys[generator() % size];
+
+  skiplist<int> list;
+  unrolled_skiplist<int> unrolled;
+  std::set<int> tree;
+  for (int k : keys) {
+    list.insert(k);
+    unrolled.insert(k);
+    tree.insert(k);
+  }
+
+  std::cout << "Scan (skiplist): " << scans(list, starts, length) << " ns" << std::endl;
+  std::cout << "Scan (unrolled_skiplist): " << scans(unrolled, starts, length) << " ns" << std::endl;
+  std::cout << "Scan (std::set): " << scans(tree, starts, length) << " ns" << std::endl;
+}
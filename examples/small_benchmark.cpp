@@ -0,0 +1,48 @@
+#include <iostream>
+#include <skiplist.hpp>
+#include <chrono>
+#include <vector>
+
+// build and tear down `lists` skiplists holding `elements` each
+double churn(int lists, int elements) {
+  auto t1 = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < lists; ++i) {
+    skiplist<int> list;
+    for (int e = 0; e < elements; ++e)
+      list.insert(e);
+  }
+  auto t2 = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::nano> time_taken = t2 - t1;
+  return time_taken.count() / lists;
+}
+
+// same, but every list is moved once before it dies
+double churn_moved(int lists, int elements) {
+  std::vector<skiplist<int>> keep;
+  keep.reserve(lists);
+  auto t1 = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < lists; ++i) {
+    skiplist<int> list;
+    for (int e = 0; e < elements; ++e)
+      list.insert(e);
+    keep.push_back(std::move(list));
+  }
+  keep.clear();
+  auto t2 = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::nano> time_taken = t2 - t1;
+  return time_taken.count() / lists;
+}
+
+int main(int argc, char *argv[]) {
+  int lists = 1000000;
+  if (argc > 1) {
+    lists = atoi(argv[1]);
+  }
+  std::cout << "Lists set to: " << lists << std::endl;
+  std::cout << "sizeof(skiplist<int>): " << sizeof(skiplist<int>) << " bytes" << std::endl;
+
+  std::cout << "Empty: " << churn(lists, 0) << " ns/list" << std::endl;
+  std::cout << "Four elements: " << churn(lists, 4) << " ns/list" << std::endl;
+  std::cout << "Empty, moved: " << churn_moved(lists, 0) << " ns/list" << std::endl;
+  std::cout << "Four elements, moved: " << churn_moved(lists, 4) << " ns/list" << std::endl;
+}
@@ -0,0 +1,94 @@
+#include <iostream>
+#include <skiplist.hpp>
+#include <cassert>
+#include <chrono>
+#include <random>
+#include <vector>
+
+using clock_type = std::chrono::high_resolution_clock;
+
+double us_since(clock_type::time_point t) {
+  std::chrono::duration<double, std::micro> taken = clock_type::now() - t;
+  return taken.count();
+}
+
+int main(int argc, char *argv[]) {
+  int size = 1000000;
+  if (argc > 1) {
+    size = atoi(argv[1]);
+  }
+  std::cout << "Size set to: " << size << std::endl;
+
+  std::mt19937 generator(42);
+  std::vector<int> keys(size);
+  for (int &k : keys)
+    k = generator() % (size * 4);
+
+  // split off the upper half and join it back, against doing
+  // the same by moving every element through insert
+  {
+    skiplist<int> list(keys.begin(), keys.end());
+    auto t = clock_type::now();
+    skiplist<int> upper = list.split(size * 2);
+    double split = us_since(t);
+    t = clock_type::now();
+    list.join(upper);
+    double join = us_since(t);
+    std::cerr << "size " << list.size() << "\n";
+    std::cout << "Split in half: " << split << " us, join back: " << join << " us" << std::endl;
+  }
+  {
+    skiplist<int> list(keys.begin(), keys.end()), upper;
+    auto t = clock_type::now();
+    auto cut = list.lower_bound(size * 2);
+    for (auto it = cut; it != list.end(); ++it)
+      upper.insert(upper.end(), *it);
+    list.erase(cut, list.end());
+    double split = us_since(t);
+    t = clock_type::now();
+    for (int k : upper)
+      list.insert(list.end(), k);
+    double join = us_since(t);
+    std::cerr << "size " << list.size() << "\n";
+    std::cout << "Split in half by copying: " << split << " us, join back: " << join << " us" << std::endl;
+  }
+
+  // split and join back over and over. The halves share slabs after a
+  // split and hand them back on the join, which must not pile up: the
+  // pool should look the same and a cycle cost the same every time
+  {
+    const int cycles = 100;
+    skiplist<int> list(keys.begin(), keys.begin() + std::min(size, 1000));
+    SLPoolStats before = list.pool_stats();
+    double first = 0, rest = 0;
+    for (int i = 0; i < cycles; i++) {
+      auto t = clock_type::now();
+      skiplist<int> upper = list.split(size * (i % 4));
+      list.join(upper);
+      (i < 10 ? first : rest) += us_since(t);
+    }
+    SLPoolStats after = list.pool_stats();
+    assert(after.slabs == before.slabs && after.bytes == before.bytes && after.free_nodes == before.free_nodes);
+    assert(list.size() == std::min(size, 1000));
+    std::cout << "Split and join " << cycles << " times: " << first / 10 << " us per cycle at first, "
+              << rest / (cycles - 10) << " us after, " << after.slabs << " slabs before and after" << std::endl;
+  }
+
+  // merge two lists whose keys are mixed together
+  for (int small : {size / 100, size}) {
+    std::vector<int> more(small);
+    for (int &k : more)
+      k = generator() % (size * 4);
+    skiplist<int> list(keys.begin(), keys.end()), other(more.begin(), more.end());
+    auto t = clock_type::now();
+    list.merge(other);
+    double merge = us_since(t);
+    skiplist<int> copy(keys.begin(), keys.end());
+    t = clock_type::now();
+    for (int k : more)
+      copy.insert(k);
+    double insert = us_since(t);
+    std::cerr << "size " << list.size() << " " << copy.size() << "\n";
+    std::cout << "Merge " << small << " elements: " << merge << " us, inserting them: " << insert << " us" << std::endl;
+  }
+}
@@ -0,0 +1,77 @@
+#include <iostream>
+#include <skiplist.hpp>
+#include <chrono>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+// same list, with plain links and with string prefixes in the links
+using plain_list = skiplist<std::string, std::less<std::string>, SLHalfLevels<>, std::allocator<std::string>, false>;
+using prefix_list = skiplist<std::string>;
+
+template <typename List>
+double lookups(const std::vector<std::string> &keys, const std::vector<std::string> &probes) {
+  List list;
+  for (const std::string &k : keys)
+    list.insert(k);
+
+  long found = 0;
+  auto t1 = std::chrono::high_resolution_clock::now();
+  for (const std::string &p : probes)
+    found += list.find(p) != list.end();
+  auto t2 = std::chrono::high_resolution_clock::now();
+  std::cerr << "found " << found << "\n";
+
+  std::chrono::duration<double, std::nano> time_taken = t2 - t1;
+  return time_taken.count() / probes.size();
+}
+
+void run(const char *name, const std::vector<std::string> &keys, std::mt19937 &generator, int iterations) {
+  std::vector<std::string> probes(iterations);
+  for (std::string &p : probes)
+    p = keys[generator() % keys.size()];
+  std::cout << name << std::endl;
+  std::cout << "Find (plain links): " << lookups<plain_list>(keys, probes) << " ns" << std::endl;
+  std::cout << "Find (prefixes): " << lookups<prefix_list>(keys, probes) << " ns" << std::endl;
+  std::cout << "Find (std::multiset): " << lookups<std::multiset<std::string>>(keys, probes) << " ns" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  int size = 1000000;
+  int iterations = 1000000;
+  if (argc > 1) {
+    size = atoi(argv[1]);
+  }
+  if (argc > 2) {
+    iterations = atoi(argv[2]);
+  }
+  std::cout << "Size set to: " << size << std::endl;
+  std::cout << "Iterations set to: " << iterations << std::endl;
+
+  std::mt19937 generator(42);
+  const char letters[] = "abcdefghijklmnopqrstuvwxyz";
+  // words of 16 to 40 letters, too long to be stored inside the string
+  std::vector<std::string> words(size);
+  for (std::string &w : words) {
+    int length = 16 + generator() % 25;
+    for (int i = 0; i < length; i++)
+      w += letters[generator() % 26];
+  }
+  run("Random words:", words, generator, iterations);
+
+  // paths a few directories deep, which share their first bytes a lot more
+  const char *roots[] = {"/usr/", "/home/", "/var/", "/opt/", "/etc/", "/srv/"};
+  std::vector<std::string> paths(size);
+  for (std::string &p : paths) {
+    p = roots[generator() % 6];
+    int depth = 2 + generator() % 3;
+    for (int d = 0; d < depth; d++) {
+      for (int i = 0, length = 3 + generator() % 6; i < length; i++)
+        p += letters[generator() % 26];
+      p += '/';
+    }
+    p += std::to_string(generator() % 1000);
+  }
+  run("Paths:", paths, generator, iterations);
+}
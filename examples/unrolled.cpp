@@ -0,0 +1,114 @@
+#include <iostream>
+#include <cassert>
+#include <random>
+#include <set>
+#include <unrolled_skiplist.hpp>
+#include "multiset_check.hpp"
+
+// Blocks of 4 split every few inserts and merge every few erases, with
+// runs of equal keys that span several blocks
+void blocks(std::mt19937 &generator) {
+    unrolled_skiplist<entry, std::less<entry>, SLHalfLevels<>, std::allocator<entry>, 4> list;
+    std::multiset<entry> expected;
+    int id = 0;
+    // in order, in reverse, then at random over few keys
+    for(int i=0; i<2000; i++) {
+        entry e = {i, id++};
+        list.insert(e);
+        expected.insert(e);
+    }
+    for(int i=0; i<2000; i++) {
+        entry e = {-i, id++};
+        list.insert(e);
+        expected.insert(e);
+    }
+    for(int i=0; i<4000; i++) {
+        entry e = {int(generator() % 50), id++};
+        list.insert(e);
+        expected.insert(e);
+    }
+    same(list, expected);
+    for(int k=0; k<50; k++) {
+        entry e = {k, 0};
+        assert(list.count(e) == (int)expected.count(e));
+        assert(*list.find(e) == *expected.find(e));
+    }
+
+    // erasing most of it merges the blocks back, which frees them
+    SLPoolStats full = list.pool_stats();
+    for(int i=0; i<6000; i++) {
+        entry e = {int(generator() % 4000) - 2000, 0};
+        list.erase(e);
+        erase_newest(expected, e);
+    }
+    same(list, expected);
+    assert(list.pool_stats().free_nodes > full.free_nodes);
+
+    // erase by iterator: every other element, then runs of them
+    auto it = list.begin();
+    auto eit = expected.begin();
+    for(bool keep = false; it != list.end(); keep = !keep) {
+        if(keep) {
+            ++it;
+            ++eit;
+        }
+        else {
+            it = list.erase(it);
+            eit = expected.erase(eit);
+            assert(it == list.end() ? eit == expected.end() : *it == *eit);
+        }
+    }
+    same(list, expected);
+    while(list.size()) {
+        it = list.find(*list.begin());
+        eit = expected.find(*expected.begin());
+        for(int i=0; i<7 && it != list.end(); i++) {
+            it = list.erase(it);
+            eit = expected.erase(eit);
+        }
+        same(list, expected);
+    }
+    assert(list.begin() == list.end());
+
+    // an emptied list fills up again
+    for(int i=0; i<500; i++) {
+        entry e = {int(generator() % 100), id++};
+        list.insert(e);
+        expected.insert(e);
+    }
+    same(list, expected);
+}
+
+// default sized blocks, copies and moves of a list full of holes
+void copies(std::mt19937 &generator) {
+    unrolled_skiplist<int> list;
+    std::multiset<int> expected;
+    for(int i=0; i<20000; i++) {
+        int value = int(generator() % 5000) - 2500;
+        list.insert(value);
+        expected.insert(value);
+        if(i % 3 == 0) {
+            value = int(generator() % 5000) - 2500;
+            list.erase(value);
+            erase_newest(expected, value);
+        }
+    }
+    same(list, expected);
+
+    unrolled_skiplist<int> copy(list);
+    same(copy, expected);
+    unrolled_skiplist<int> moved(std::move(copy));
+    same(moved, expected);
+    assert(copy.size() == 0 && copy.begin() == copy.end());
+    copy = moved;
+    moved.clear();
+    same(copy, expected);
+    assert(moved.size() == 0);
+}
+
+int main() {
+    std::mt19937 generator(42);
+    blocks(generator);
+    copies(generator);
+    std::cout << "unrolled_skiplist matches std::multiset" << std::endl;
+}
@@ -0,0 +1,444 @@
+/*
+Compact skip list implementation
+Same interface as skiplist, but nodes refer to each other by 32-bit
+indices into arenas instead of pointers
+*/
+#ifndef COMPACT_SKIPLIST_H
+#define COMPACT_SKIPLIST_H
+#include <vector>
+#include <iterator>
+#include <initializer_list>
+#include <memory>
+#include <cstdint>
+#include <stdexcept>
+
+#include "skiplist_level.hpp"
+
+// Nodes live in a handful of arrays, all indexed by a 32-bit node id:
+//   vals_[id]   the element
+//   back_[id]   previous node at level 0
+//   tower_[id]  where the forward links of the node start in links_
+//   height_[id] number of levels the node spans
+// links_ is one contiguous arena of 32-bit forward links, every tower
+// taking height_[id] consecutive entries.
+// Halving the link size caps a list at 4G nodes (and 4G links).
+// Equal elements get a node each, placed after the ones already there.
+template<
+    typename val_type,
+    typename compare_t = std::less<val_type>,
+    typename level_t = SLHalfLevels<>,
+    typename alloc_t = std::allocator<val_type>
+>
+class compact_skiplist {
+private:
+    using alloc_traits = std::allocator_traits<alloc_t>;
+    using val_alloc_t = typename alloc_traits::template rebind_alloc<val_type>;
+    using index_alloc_t = typename alloc_traits::template rebind_alloc<std::uint32_t>;
+    using height_alloc_t = typename alloc_traits::template rebind_alloc<std::uint8_t>;
+
+    static_assert(level_t::max_level < 256, "heights are stored in a byte");
+
+    // stands in for nullptr, and for the header in a search path
+    enum : std::uint32_t { nil = 0xFFFFFFFFu };
+
+    std::vector<val_type, val_alloc_t> vals_;
+    std::vector<std::uint32_t, index_alloc_t> back_, tower_, links_;
+    std::vector<std::uint8_t, height_alloc_t> height_;
+
+    // first node of every level, only the first levels_ entries are used
+    std::uint32_t key[level_t::max_level];
+    int levels_;
+    // number of elements in the skiplist (including non-unique ones),
+    // unsigned to count all the way up to the 4G node cap
+    std::uint32_t size_;
+    // the last node at level 0
+    std::uint32_t last;
+
+    // erased node ids, chained through back_
+    std::uint32_t free_ids_;
+    // erased towers, one chain per height, chained through their first link
+    std::uint32_t free_towers_[level_t::max_level];
+
+    // random numbers for tower heights, seeded on first use
+    SLRandom rng_;
+
+    // template objects, since compare is supposed to be a functor
+    compare_t compare;
+    // picks the height of new towers, see skiplist_level.hpp
+    level_t levels;
+
+    void _reset() {
+        levels_ = 0;
+        size_ = 0;
+        last = nil;
+        free_ids_ = nil;
+        for(int i=0; i<level_t::max_level; i++)
+            key[i] = free_towers_[i] = nil;
+    }
+
+    // forward link of node at a level. nil stands in for the header
+    std::uint32_t &_next(std::uint32_t node, int level) {
+        return node == nil ? key[level] : links_[tower_[node] + level];
+    }
+    const std::uint32_t &_next(std::uint32_t node, int level) const {
+        return node == nil ? key[level] : links_[tower_[node] + level];
+    }
+
+    int _random_height() {
+        int height = levels(rng_), limit = level_t::level_limit(size_);
+        return height < limit ? height : limit;
+    }
+
+    // an unused node id and tower, from the free chains if possible
+    std::uint32_t _new_node(const val_type &value, int height);
+    // put a node's id and tower on the free chains
+    void _free_node(std::uint32_t node);
+
+    // last node before value at every level, nil for the header.
+    // returns the first node not less than value at level 0
+    std::uint32_t _find_path(const val_type &value, std::uint32_t *history) const;
+    // predecessors of a node that is in the list
+    void _path_to(std::uint32_t node, std::uint32_t *history) const;
+    // unlink a node from every level and free it
+    void _remove_node(std::uint32_t node, std::uint32_t *history);
+
+    void _copy_header(const compact_skiplist &other) {
+        for(int i=0; i<level_t::max_level; i++) {
+            key[i] = other.key[i];
+            free_towers_[i] = other.free_towers_[i];
+        }
+        levels_ = other.levels_;
+        size_ = other.size_;
+        last = other.last;
+        free_ids_ = other.free_ids_;
+    }
+
+public:
+    template<bool reversal = false>
+    class cake_iterator;
+
+    using const_iterator = cake_iterator<>;
+    using iterator = const_iterator;
+    using const_reverse_iterator = cake_iterator<true>;
+    using reverse_iterator = const_reverse_iterator;
+
+    compact_skiplist() { _reset(); }
+
+    explicit compact_skiplist(const alloc_t &alloc)
+    : vals_(val_alloc_t(alloc)), back_(index_alloc_t(alloc)), tower_(index_alloc_t(alloc)),
+      links_(index_alloc_t(alloc)), height_(height_alloc_t(alloc)) {
+        _reset();
+    }
+
+    template<typename InputIterator>
+    compact_skiplist(InputIterator first, InputIterator last, const alloc_t &alloc = alloc_t())
+    : compact_skiplist(alloc) {
+        while(first != last) {
+            insert(*first);
+            ++first;
+        }
+    }
+
+    compact_skiplist(std::initializer_list<val_type> l, const alloc_t &alloc = alloc_t())
+    : compact_skiplist(l.begin(), l.end(), alloc) {}
+
+    // nodes only refer to each other by index,
+    // so copying the arrays copies the structure
+    compact_skiplist(const compact_skiplist &other)
+    : vals_(other.vals_), back_(other.back_), tower_(other.tower_),
+      links_(other.links_), height_(other.height_) {
+        _copy_header(other);
+    }
+
+    compact_skiplist(compact_skiplist &&other)
+    : vals_(std::move(other.vals_)), back_(std::move(other.back_)),
+      tower_(std::move(other.tower_)), links_(std::move(other.links_)),
+      height_(std::move(other.height_)) {
+        _copy_header(other);
+        rng_ = other.rng_;
+        other.clear();
+    }
+
+    compact_skiplist &operator=(const compact_skiplist &rhs) {
+        if(this == &rhs)
+            return *this;
+        vals_ = rhs.vals_;
+        back_ = rhs.back_;
+        tower_ = rhs.tower_;
+        links_ = rhs.links_;
+        height_ = rhs.height_;
+        _copy_header(rhs);
+        return *this;
+    }
+
+    compact_skiplist &operator=(compact_skiplist &&rhs) {
+        if(this == &rhs)
+            return *this;
+        vals_ = std::move(rhs.vals_);
+        back_ = std::move(rhs.back_);
+        tower_ = std::move(rhs.tower_);
+        links_ = std::move(rhs.links_);
+        height_ = std::move(rhs.height_);
+        _copy_header(rhs);
+        rhs.clear();
+        return *this;
+    }
+
+    // drop every element, giving the arenas back
+    void clear() {
+        vals_.clear();
+        back_.clear();
+        tower_.clear();
+        links_.clear();
+        height_.clear();
+        vals_.shrink_to_fit();
+        back_.shrink_to_fit();
+        tower_.shrink_to_fit();
+        links_.shrink_to_fit();
+        height_.shrink_to_fit();
+        _reset();
+    }
+
+    void insert(const val_type &value);
+    // removes the most recently inserted of the elements equal to value
+    void erase(const val_type &value);
+    iterator erase(iterator it);
+    // the first of the elements equal to value
+    iterator find(const val_type &value) const;
+
+    std::size_t count(const val_type &value) const {
+        std::size_t found = 0;
+        for(iterator it = find(value); it != end() && !compare(value, *it); ++it)
+            ++found;
+        return found;
+    }
+    std::size_t size() const { return size_; }
+    alloc_t get_allocator() const { return alloc_t(vals_.get_allocator()); }
+
+    iterator begin() const { return iterator(this, levels_ ? key[0] : nil); }
+    iterator end() const { return iterator(this, nil); }
+    reverse_iterator rbegin() const { return reverse_iterator(this, last); }
+    reverse_iterator rend() const { return reverse_iterator(this, nil); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+    const_reverse_iterator crbegin() const { return rbegin(); }
+    const_reverse_iterator crend() const { return rend(); }
+};
+
+// Iterator is a list and a node id, nil for end().
+// Ids stay put when the arrays grow, so an iterator outlives inserts,
+// but it points at the list object rather than at its storage: moving
+// or swapping the list leaves it pointing at the old object
+template<
+    typename val_type,
+    typename compare_t,
+    typename level_t,
+    typename alloc_t
+>
+template<bool reversal>
+class compact_skiplist<val_type, compare_t, level_t, alloc_t>::cake_iterator {
+private:
+    const compact_skiplist *list_;
+    std::uint32_t node_;
+
+    friend class compact_skiplist;
+
+    std::uint32_t _forward() const { return list_->_next(node_, 0); }
+    std::uint32_t _backward() const { return list_->back_[node_]; }
+
+public:
+    using difference_type = std::ptrdiff_t;
+    using value_type = val_type;
+    using pointer = const val_type*;
+    using reference = const val_type&;
+    using iterator_category = std::bidirectional_iterator_tag;
+
+    cake_iterator(const compact_skiplist *list, std::uint32_t node)
+    : list_(list), node_(node) {}
+
+    bool operator==(const cake_iterator &rhs) const { return node_ == rhs.node_; }
+    bool operator!=(const cake_iterator &rhs) const { return node_ != rhs.node_; }
+
+    const val_type &operator*() const { return list_->vals_[node_]; }
+    const val_type *operator->() const { return &list_->vals_[node_]; }
+
+    cake_iterator &operator++() {
+        node_ = reversal ? _backward() : _forward();
+        return *this;
+    }
+    cake_iterator operator++(int) {
+        cake_iterator temp(*this);
+        ++*this;
+        return temp;
+    }
+    cake_iterator &operator--() {
+        node_ = reversal ? _forward() : _backward();
+        return *this;
+    }
+    cake_iterator operator--(int) {
+        cake_iterator temp(*this);
+        --*this;
+        return temp;
+    }
+};
+
+
+/*
+================================================================================
+=================== NOTE! THE PART BELOW IS FROM THE CPP FILE ==================
+================================================================================
+*/
+
+template<typename T, typename X, typename L, typename A>
+std::uint32_t compact_skiplist<T, X, L, A>::_new_node(const T &value, int height) {
+    std::uint32_t node, tower;
+    if(free_ids_ != nil) {
+        node = free_ids_;
+        free_ids_ = back_[node];
+        vals_[node] = value;
+    }
+    else {
+        if(vals_.size() >= nil)
+            throw std::length_error("compact_skiplist: more than 2^32 - 1 nodes");
+        node = (std::uint32_t)vals_.size();
+        vals_.push_back(value);
+        back_.push_back(nil);
+        tower_.push_back(nil);
+        height_.push_back(0);
+    }
+    if(free_towers_[height - 1] != nil) {
+        tower = free_towers_[height - 1];
+        free_towers_[height - 1] = links_[tower];
+    }
+    else {
+        if(links_.size() + height >= nil)
+            throw std::length_error("compact_skiplist: more than 2^32 - 1 links");
+        tower = (std::uint32_t)links_.size();
+        links_.resize(links_.size() + height);
+    }
+    tower_[node] = tower;
+    height_[node] = (std::uint8_t)height;
+    return node;
+}
+
+template<typename T, typename X, typename L, typename A>
+void compact_skiplist<T, X, L, A>::_free_node(std::uint32_t node) {
+    // The slot stays in vals_ until the id is reused, but whatever the
+    // element holds (a string's buffer, a handle) goes now: it is moved
+    // out to a temporary that dies right here
+    {
+        T gone(std::move(vals_[node]));
+    }
+    int height = height_[node];
+    links_[tower_[node]] = free_towers_[height - 1];
+    free_towers_[height - 1] = tower_[node];
+    back_[node] = free_ids_;
+    free_ids_ = node;
+}
+
+template<typename T, typename X, typename L, typename A>
+std::uint32_t compact_skiplist<T, X, L, A>::_find_path(const T &value, std::uint32_t *history) const {
+    std::uint32_t follow = nil, next;
+    for(int level = levels_ - 1; level >= 0; --level) {
+        while((next = _next(follow, level)) != nil && compare(vals_[next], value))
+            follow = next;
+        history[level] = follow;
+    }
+    return levels_ ? _next(follow, 0) : nil;
+}
+
+template<typename T, typename X, typename L, typename A>
+void compact_skiplist<T, X, L, A>::_path_to(std::uint32_t node, std::uint32_t *history) const {
+    _find_path(vals_[node], history);
+    // everything between the path and the node is equal to it,
+    // so just walk up to it on every level it spans
+    for(int level = 0; level < height_[node]; ++level)
+        while(_next(history[level], level) != node)
+            history[level] = _next(history[level], level);
+}
+
+template<typename T, typename X, typename L, typename A>
+void compact_skiplist<T, X, L, A>::_remove_node(std::uint32_t node, std::uint32_t *history) {
+    for(int level = 0; level < height_[node]; ++level)
+        _next(history[level], level) = _next(node, level);
+    std::uint32_t after = _next(node, 0);
+    if(after != nil)
+        back_[after] = back_[node];
+    else
+        last = back_[node];
+    _free_node(node);
+    --size_;
+    // Drop levels that became empty
+    while(levels_ && key[levels_ - 1] == nil)
+        --levels_;
+}
+
+template<typename T, typename X, typename L, typename A>
+// Equal elements keep their insertion order
+void compact_skiplist<T, X, L, A>::insert(const T &value) {
+    std::uint32_t history[L::max_level], follow = nil, next;
+    // stop past the elements equal to value, new ones go last
+    for(int level = levels_ - 1; level >= 0; --level) {
+        while((next = _next(follow, level)) != nil && !compare(value, vals_[next]))
+            follow = next;
+        history[level] = follow;
+    }
+
+    int height = _random_height();
+    // counted once _new_node has not thrown at the cap
+    std::uint32_t node = _new_node(value, height);
+    ++size_;
+    while(levels_ < height) {
+        key[levels_] = nil;
+        history[levels_++] = nil;
+    }
+    for(int level = 0; level < height; ++level) {
+        _next(node, level) = _next(history[level], level);
+        _next(history[level], level) = node;
+    }
+    back_[node] = history[0];
+    next = _next(node, 0);
+    if(next != nil)
+        back_[next] = node;
+    else
+        last = node;
+}
+
+template<typename T, typename X, typename L, typename A>
+// Cannot assume element exists
+void compact_skiplist<T, X, L, A>::erase(const T &value) {
+    std::uint32_t history[L::max_level];
+    std::uint32_t node = _find_path(value, history);
+    if(node == nil || compare(value, vals_[node]))
+        return;
+    // the last equal one is the most recent
+    std::uint32_t next;
+    while((next = _next(node, 0)) != nil && !compare(value, vals_[next]))
+        node = next;
+    _path_to(node, history);
+    _remove_node(node, history);
+}
+
+template<typename T, typename X, typename L, typename A>
+// Assume that iterator is valid
+// After erasing, move on to the next element
+typename compact_skiplist<T, X, L, A>::iterator
+compact_skiplist<T, X, L, A>::erase(typename compact_skiplist<T, X, L, A>::iterator it) {
+    std::uint32_t history[L::max_level], node = it.node_, ret = _next(node, 0);
+    _path_to(node, history);
+    _remove_node(node, history);
+    return iterator(this, ret);
+}
+
+template<typename T, typename X, typename L, typename A>
+typename compact_skiplist<T, X, L, A>::iterator compact_skiplist<T, X, L, A>::find(const T &value) const {
+    std::uint32_t history[L::max_level];
+    std::uint32_t node = _find_path(value, history);
+    if(node == nil || compare(value, vals_[node]))
+        return end();
+    return iterator(this, node);
+}
+// End of cpp file
+
+#endif
+// End of header file
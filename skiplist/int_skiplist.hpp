@@ -0,0 +1,717 @@
+/*
+Integer skip list implementation
+Same interface as compact_skiplist, for integer keys only. Level 0 is a
+list of blocks holding keys as delta encoded varints
+*/
+#ifndef INT_SKIPLIST_H
+#define INT_SKIPLIST_H
+#include <iterator>
+#include <initializer_list>
+#include <new>
+#include <memory>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+
+#include "skiplist_pool.hpp"
+#include "skiplist_level.hpp"
+
+// LEB128 varints: 7 bits a byte, lowest first,
+// the top bit set on every byte but the last
+template<typename U>
+inline int _sl_varint_size(U v) {
+    int bytes = 1;
+    while(v >= 0x80) {
+        v >>= 7;
+        ++bytes;
+    }
+    return bytes;
+}
+
+template<typename U>
+inline unsigned char *_sl_varint_put(unsigned char *out, U v) {
+    while(v >= 0x80) {
+        *out++ = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    *out++ = (unsigned char)v;
+    return out;
+}
+
+template<typename U>
+inline const unsigned char *_sl_varint_get(const unsigned char *in, U &v) {
+    v = 0;
+    int shift = 0;
+    unsigned char byte;
+    do {
+        byte = *in++;
+        v |= (U)(byte & 0x7f) << shift;
+        shift += 7;
+    } while(byte & 0x80);
+    return in;
+}
+
+// A run of sorted keys, which is also a tower. The first key is kept as
+// is, every other one as its difference from the key before it, in a
+// varint. The last key is kept as is too, so that searches and stepping
+// back into a block need no decoding.
+template<typename T, int Bytes>
+struct SLPackedBlock {
+    // previous block at level 0
+    SLPackedBlock *back;
+    T first, last;
+    // number of keys, and bytes of data holding their differences
+    int count, used;
+    // number of levels this tower spans
+    int height;
+    unsigned char data[Bytes];
+    // forward pointers, over-allocated like the ones of SLNode
+    SLPackedBlock *next[1];
+
+    template<typename Pool>
+    static SLPackedBlock *create(Pool &pool, int height_) {
+        return new(pool.allocate(height_)) SLPackedBlock(height_);
+    }
+    template<typename Pool>
+    static void destroy(Pool &pool, SLPackedBlock *blk) {
+        pool.deallocate(blk, blk->height);
+    }
+    static std::size_t bytes(int height_) {
+        return sizeof(SLPackedBlock) + (height_ - 1) * sizeof(SLPackedBlock*);
+    }
+
+private:
+    explicit SLPackedBlock(int height_)
+    : back(nullptr), first(), last(), count(0), used(0), height(height_) {
+        for(int i=0; i<height_; i++)
+            next[i] = nullptr;
+    }
+};
+
+// Sorted integers, packed. Consecutive keys in a set of ids tend to be
+// close, so most differences take a byte or two instead of a whole key,
+// let alone a whole node.
+// Blocks hold up to block_bytes bytes of differences. One that overflows
+// splits in two, one that drops under a quarter full is joined to a
+// neighbour if the two fit in one block. Only blocks get towers.
+// Changing a block decodes it, edits the keys and encodes it again,
+// which is cheap next to finding it.
+// Iterators decode on the fly, so they hand out references to a copy
+// of the key they hold, which only lives as long as they stay put.
+template<
+    typename int_type = int,
+    typename level_t = SLHalfLevels<>,
+    typename alloc_t = std::allocator<int_type>,
+    int block_bytes = 256
+>
+class int_skiplist {
+private:
+    static_assert(std::is_integral<int_type>::value, "keys must be integers");
+    // an insert grows the data by at most one varint,
+    // both halves of a split must still fit in a block
+    static_assert(block_bytes >= 64, "blocks must be able to split");
+
+    using unsigned_t = typename std::make_unsigned<int_type>::type;
+    using block_t = SLPackedBlock<int_type, block_bytes>;
+    using alloc_traits = std::allocator_traits<alloc_t>;
+
+    // most keys a block can hold, every difference takes a byte at least.
+    // one more fits in the buffers, for the key being inserted
+    enum { max_keys = block_bytes + 1 };
+
+    // first block of every level, only the first levels_ entries are used
+    block_t *key[level_t::max_level];
+    int levels_;
+    // number of elements in the skiplist (including non-unique ones)
+    int size_;
+    // number of blocks, which is what the towers are built over
+    int blocks_;
+    // the last block at level 0
+    block_t *last;
+    // every block lives in here
+    SLNodePool<block_t, level_t::max_level, alloc_t> pool_;
+
+    // random numbers for tower heights, seeded on first use
+    SLRandom rng_;
+    // picks the height of new towers, see skiplist_level.hpp
+    level_t levels;
+
+    void _reset() {
+        levels_ = 0;
+        size_ = 0;
+        blocks_ = 0;
+        last = nullptr;
+    }
+
+    // forward pointers leaving a block. nullptr stands in for the header
+    block_t **_links(block_t *blk) { return blk ? blk->next : key; }
+
+    int _random_height() {
+        int height = levels(rng_), limit = level_t::level_limit(blocks_);
+        return height < limit ? height : limit;
+    }
+
+    // difference between two keys, b not less than a
+    static unsigned_t _delta(int_type a, int_type b) { return (unsigned_t)b - (unsigned_t)a; }
+
+    // unpack the keys of a block, returns how many
+    static int _decode(const block_t *blk, int_type *keys);
+    // pack keys into a block, they must fit
+    static void _encode(block_t *blk, const int_type *keys, int n);
+    // bytes the differences between n keys take
+    static int _packed_size(const int_type *keys, int n) {
+        int bytes = 0;
+        for(int i=1; i<n; i++)
+            bytes += _sl_varint_size(_delta(keys[i - 1], keys[i]));
+        return bytes;
+    }
+    // bytes left and right take packed into one block
+    static int _joined_size(const block_t *left, const block_t *right) {
+        return left->used + _sl_varint_size(_delta(left->last, right->first)) + right->used;
+    }
+    // move every key of right to the end of left
+    static void _join(block_t *left, block_t *right);
+
+    // last block starting at or before value on every level, nullptr for
+    // the header. returns that block at level 0
+    block_t *_upper_path(int_type value, block_t **history);
+    // last block starting before value, nullptr if there is none
+    block_t *_lower_block(int_type value) const;
+    // predecessors of a block that is in the list
+    void _path_to(block_t *blk, block_t **history);
+
+    // a new empty block linked in right after history at level 0
+    block_t *_new_block(block_t **history);
+    // unlink a block from every level and free it
+    void _remove_block(block_t *blk, block_t **history);
+
+    // copy the blocks of other, appending each to the levels it spans
+    void _copy_blocks(const int_skiplist &other);
+
+public:
+    template<bool reversal = false>
+    class cake_iterator;
+
+    using const_iterator = cake_iterator<>;
+    using iterator = const_iterator;
+    using const_reverse_iterator = cake_iterator<true>;
+    using reverse_iterator = const_reverse_iterator;
+
+    int_skiplist() { _reset(); }
+
+    // every block comes out of alloc
+    explicit int_skiplist(const alloc_t &alloc) : pool_(alloc) { _reset(); }
+
+    template<typename InputIterator>
+    int_skiplist(InputIterator first, InputIterator last, const alloc_t &alloc = alloc_t())
+    : int_skiplist(alloc) {
+        while(first != last) {
+            insert(*first);
+            ++first;
+        }
+    }
+
+    int_skiplist(std::initializer_list<int_type> l, const alloc_t &alloc = alloc_t())
+    : int_skiplist(l.begin(), l.end(), alloc) {}
+
+    int_skiplist(const int_skiplist &other)
+    : int_skiplist(other, alloc_traits::select_on_container_copy_construction(
+                              other.get_allocator())) {}
+
+    int_skiplist(const int_skiplist &other, const alloc_t &alloc)
+    : pool_(alloc) {
+        _reset();
+        _copy_blocks(other);
+    }
+
+    int_skiplist(int_skiplist &&other)
+    : levels_(other.levels_), size_(other.size_), blocks_(other.blocks_),
+      last(other.last), pool_(std::move(other.pool_)), rng_(other.rng_) {
+        for(int i=0; i<levels_; i++)
+            key[i] = other.key[i];
+        other._reset();
+    }
+
+    ~int_skiplist() { clear(); }
+
+    int_skiplist &operator=(const int_skiplist &rhs) {
+        if(this == &rhs)
+            return *this;
+        clear();
+        _copy_blocks(rhs);
+        return *this;
+    }
+
+    int_skiplist &operator=(int_skiplist &&rhs) {
+        if(this == &rhs)
+            return *this;
+        clear();
+        // blocks can only change hands if our allocator can free them
+        if(!alloc_traits::propagate_on_container_move_assignment::value
+           && get_allocator() != rhs.get_allocator()) {
+            _copy_blocks(rhs);
+            rhs.clear();
+            return *this;
+        }
+        pool_ = std::move(rhs.pool_);
+        for(int i=0; i<rhs.levels_; i++)
+            key[i] = rhs.key[i];
+        levels_ = rhs.levels_;
+        size_ = rhs.size_;
+        blocks_ = rhs.blocks_;
+        last = rhs.last;
+        rhs._reset();
+        return *this;
+    }
+
+    // drop every key, giving the slabs back.
+    // blocks hold nothing to destroy, only the ones off the heap need freeing
+    void clear() {
+        block_t *blk = levels_ ? key[0] : nullptr, *tmp;
+        while(blk) {
+            tmp = blk->next[0];
+            if(pool_.from_heap(blk->height))
+                block_t::destroy(pool_, blk);
+            blk = tmp;
+        }
+        pool_.release();
+        _reset();
+    }
+
+    void insert(int_type value);
+    void erase(int_type value);
+    iterator erase(iterator it);
+    iterator find(int_type value) const;
+
+    int count(int_type value) const {
+        int found = 0;
+        for(iterator it = find(value); it != end() && *it == value; ++it)
+            ++found;
+        return found;
+    }
+    int size() const { return size_; }
+    alloc_t get_allocator() const { return alloc_t(pool_.get_allocator()); }
+    // slabs and free blocks held by the pool, which is all the memory there is
+    SLPoolStats pool_stats() const { return pool_.stats(); }
+
+    iterator begin() const { return iterator(this, levels_ ? key[0] : nullptr); }
+    iterator end() const { return iterator(this, nullptr); }
+    reverse_iterator rbegin() const { return reverse_iterator(this, last, true); }
+    reverse_iterator rend() const { return reverse_iterator(this, nullptr); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+    const_reverse_iterator crbegin() const { return rbegin(); }
+    const_reverse_iterator crend() const { return rend(); }
+
+private:
+    // drop keys[pos] of a block that unpacks to keys, joining blocks that
+    // got too empty. returns where the key after it ended up
+    iterator _erase_at(block_t *blk, int_type *keys, int n, int pos);
+    // the key at pos in a block, the next block's first one past the end
+    iterator _at(block_t *blk, int pos) const;
+};
+
+// Iterator is a block, a position in it, where the next difference
+// starts in its data and the key itself. nullptr for end()
+template<
+    typename int_type,
+    typename level_t,
+    typename alloc_t,
+    int block_bytes
+>
+template<bool reversal>
+class int_skiplist<int_type, level_t, alloc_t, block_bytes>::cake_iterator {
+private:
+    const int_skiplist *list_;
+    const block_t *blk_;
+    int pos_, off_;
+    int_type val_;
+
+    friend class int_skiplist;
+
+    // the first or the last key of a block
+    void _front() {
+        pos_ = off_ = 0;
+        val_ = blk_ ? blk_->first : int_type();
+    }
+    void _back() {
+        if(!blk_)
+            return _front();
+        pos_ = blk_->count - 1;
+        off_ = blk_->used;
+        val_ = blk_->last;
+    }
+
+    // stepping off either end gives nullptr,
+    // and stepping back from there re-enters the list
+    void _forward() {
+        if(!blk_) {
+            blk_ = list_->levels_ ? list_->key[0] : nullptr;
+            _front();
+        }
+        else if(pos_ + 1 == blk_->count) {
+            blk_ = blk_->next[0];
+            _front();
+        }
+        else {
+            unsigned_t delta;
+            off_ = int(_sl_varint_get(blk_->data + off_, delta) - blk_->data);
+            val_ = int_type((unsigned_t)val_ + delta);
+            ++pos_;
+        }
+    }
+    void _backward() {
+        if(!blk_) {
+            blk_ = list_->last;
+            _back();
+        }
+        else if(!pos_) {
+            blk_ = blk_->back;
+            _back();
+        }
+        else {
+            // the varint before off_ starts right after the last
+            // byte without the top bit, before its own last byte
+            int start = off_ - 1;
+            while(start && (blk_->data[start - 1] & 0x80))
+                --start;
+            unsigned_t delta;
+            _sl_varint_get(blk_->data + start, delta);
+            val_ = int_type((unsigned_t)val_ - delta);
+            off_ = start;
+            --pos_;
+        }
+    }
+
+public:
+    using difference_type = std::ptrdiff_t;
+    using value_type = int_type;
+    using pointer = const int_type*;
+    using reference = const int_type&;
+    using iterator_category = std::bidirectional_iterator_tag;
+
+    // at the first key of blk, or the last one
+    cake_iterator(const int_skiplist *list, const block_t *blk, bool at_back = false)
+    : list_(list), blk_(blk) {
+        if(at_back)
+            _back();
+        else
+            _front();
+    }
+
+    bool operator==(const cake_iterator &rhs) const { return blk_ == rhs.blk_ && pos_ == rhs.pos_; }
+    bool operator!=(const cake_iterator &rhs) const { return !(*this == rhs); }
+
+    const int_type &operator*() const { return val_; }
+    const int_type *operator->() const { return &val_; }
+
+    cake_iterator &operator++() {
+        if(reversal)
+            _backward();
+        else
+            _forward();
+        return *this;
+    }
+    cake_iterator operator++(int) {
+        cake_iterator temp(*this);
+        ++*this;
+        return temp;
+    }
+    cake_iterator &operator--() {
+        if(reversal)
+            _forward();
+        else
+            _backward();
+        return *this;
+    }
+    cake_iterator operator--(int) {
+        cake_iterator temp(*this);
+        --*this;
+        return temp;
+    }
+};
+
+
+/*
+================================================================================
+=================== NOTE! THE PART BELOW IS FROM THE CPP FILE ==================
+================================================================================
+*/
+
+template<typename T, typename L, typename A, int B>
+int int_skiplist<T, L, A, B>::_decode(const SLPackedBlock<T, B> *blk, T *keys) {
+    const unsigned char *in = blk->data;
+    keys[0] = blk->first;
+    for(int i=1; i<blk->count; i++) {
+        typename std::make_unsigned<T>::type delta;
+        in = _sl_varint_get(in, delta);
+        keys[i] = T((typename std::make_unsigned<T>::type)keys[i - 1] + delta);
+    }
+    return blk->count;
+}
+
+template<typename T, typename L, typename A, int B>
+void int_skiplist<T, L, A, B>::_encode(SLPackedBlock<T, B> *blk, const T *keys, int n) {
+    unsigned char *out = blk->data;
+    for(int i=1; i<n; i++)
+        out = _sl_varint_put(out, _delta(keys[i - 1], keys[i]));
+    blk->first = keys[0];
+    blk->last = keys[n - 1];
+    blk->count = n;
+    blk->used = int(out - blk->data);
+}
+
+template<typename T, typename L, typename A, int B>
+void int_skiplist<T, L, A, B>::_join(SLPackedBlock<T, B> *left, SLPackedBlock<T, B> *right) {
+    unsigned char *out = _sl_varint_put(left->data + left->used, _delta(left->last, right->first));
+    std::memcpy(out, right->data, right->used);
+    left->used = int(out - left->data) + right->used;
+    left->count += right->count;
+    left->last = right->last;
+    right->count = right->used = 0;
+}
+
+template<typename T, typename L, typename A, int B>
+SLPackedBlock<T, B> *int_skiplist<T, L, A, B>::_upper_path(T value, SLPackedBlock<T, B> **history) {
+    SLPackedBlock<T, B> *follow = nullptr, **links = key;
+    for(int level = levels_ - 1; level >= 0; --level) {
+        while(links[level] && !(value < links[level]->first)) {
+            follow = links[level];
+            links = follow->next;
+        }
+        history[level] = follow;
+    }
+    return follow;
+}
+
+template<typename T, typename L, typename A, int B>
+SLPackedBlock<T, B> *int_skiplist<T, L, A, B>::_lower_block(T value) const {
+    SLPackedBlock<T, B> *follow = nullptr;
+    SLPackedBlock<T, B> *const *links = key;
+    for(int level = levels_ - 1; level >= 0; --level) {
+        while(links[level] && links[level]->first < value) {
+            follow = links[level];
+            links = follow->next;
+        }
+    }
+    return follow;
+}
+
+template<typename T, typename L, typename A, int B>
+void int_skiplist<T, L, A, B>::_path_to(SLPackedBlock<T, B> *blk, SLPackedBlock<T, B> **history) {
+    SLPackedBlock<T, B> *follow = nullptr, **links = key;
+    for(int level = levels_ - 1; level >= 0; --level) {
+        while(links[level] && links[level]->first < blk->first) {
+            follow = links[level];
+            links = follow->next;
+        }
+        history[level] = follow;
+    }
+    // blocks of nothing but copies of blk's first key may come before it
+    for(SLPackedBlock<T, B> *at = _links(history[0])[0]; at != blk; at = at->next[0])
+        for(int level = 0; level < at->height; ++level)
+            history[level] = at;
+}
+
+template<typename T, typename L, typename A, int B>
+SLPackedBlock<T, B> *int_skiplist<T, L, A, B>::_new_block(SLPackedBlock<T, B> **history) {
+    ++blocks_;
+    SLPackedBlock<T, B> *blk = SLPackedBlock<T, B>::create(pool_, _random_height());
+    while(levels_ < blk->height) {
+        key[levels_] = nullptr;
+        history[levels_++] = nullptr;
+    }
+    for(int level = 0; level < blk->height; ++level) {
+        SLPackedBlock<T, B> **links = _links(history[level]);
+        blk->next[level] = links[level];
+        links[level] = blk;
+    }
+    blk->back = history[0];
+    if(blk->next[0])
+        blk->next[0]->back = blk;
+    else
+        last = blk;
+    return blk;
+}
+
+template<typename T, typename L, typename A, int B>
+void int_skiplist<T, L, A, B>::_remove_block(SLPackedBlock<T, B> *blk, SLPackedBlock<T, B> **history) {
+    for(int level = 0; level < blk->height; ++level)
+        _links(history[level])[level] = blk->next[level];
+    if(blk->next[0])
+        blk->next[0]->back = blk->back;
+    else
+        last = blk->back;
+    SLPackedBlock<T, B>::destroy(pool_, blk);
+    --blocks_;
+    // Drop levels that became empty
+    while(levels_ && !key[levels_ - 1])
+        --levels_;
+}
+
+template<typename T, typename L, typename A, int B>
+void int_skiplist<T, L, A, B>::_copy_blocks(const int_skiplist &other) {
+    if(!other.levels_)
+        return;
+    // the last block built so far at every level, nullptr is the header
+    SLPackedBlock<T, B> *tails[L::max_level];
+    for(int i=0; i<other.levels_; i++)
+        tails[i] = key[i] = nullptr;
+    levels_ = other.levels_;
+    for(const SLPackedBlock<T, B> *from = other.key[0]; from; from = from->next[0]) {
+        SLPackedBlock<T, B> *blk = SLPackedBlock<T, B>::create(pool_, from->height);
+        blk->first = from->first;
+        blk->last = from->last;
+        blk->count = from->count;
+        blk->used = from->used;
+        std::memcpy(blk->data, from->data, from->used);
+        blk->back = tails[0];
+        for(int i=0; i<blk->height; i++) {
+            _links(tails[i])[i] = blk;
+            tails[i] = blk;
+        }
+    }
+    last = tails[0];
+    size_ = other.size_;
+    blocks_ = other.blocks_;
+}
+
+template<typename T, typename L, typename A, int B>
+typename int_skiplist<T, L, A, B>::iterator
+int_skiplist<T, L, A, B>::_at(SLPackedBlock<T, B> *blk, int pos) const {
+    if(pos == blk->count)
+        return iterator(this, blk->next[0]);
+    iterator it(this, blk);
+    while(it.pos_ < pos)
+        it._forward();
+    return it;
+}
+
+template<typename T, typename L, typename A, int B>
+typename int_skiplist<T, L, A, B>::iterator
+int_skiplist<T, L, A, B>::_erase_at(SLPackedBlock<T, B> *blk, T *keys, int n, int pos) {
+    SLPackedBlock<T, B> *history[L::max_level];
+    --size_;
+    if(n == 1) {
+        // the block goes away with its only key
+        SLPackedBlock<T, B> *after = blk->next[0];
+        _path_to(blk, history);
+        _remove_block(blk, history);
+        return iterator(this, after);
+    }
+
+    // the two differences around the key become one, which is no longer
+    std::copy(keys + pos + 1, keys + n, keys + pos);
+    _encode(blk, keys, n - 1);
+
+    if(blk->used < B / 4) {
+        SLPackedBlock<T, B> *right = blk->next[0], *left = blk->back;
+        if(right && _joined_size(blk, right) <= B) {
+            _path_to(right, history);
+            _join(blk, right);
+            _remove_block(right, history);
+        }
+        else if(left && _joined_size(left, blk) <= B) {
+            _path_to(blk, history);
+            pos += left->count;
+            _join(left, blk);
+            _remove_block(blk, history);
+            blk = left;
+        }
+    }
+    return _at(blk, pos);
+}
+
+template<typename T, typename L, typename A, int B>
+// Equal keys are all kept
+void int_skiplist<T, L, A, B>::insert(T value) {
+    SLPackedBlock<T, B> *history[L::max_level];
+    // the last block starting at or before value takes it
+    SLPackedBlock<T, B> *blk = _upper_path(value, history);
+    if(!blk) {
+        // smaller than everything, goes in front of the first block
+        blk = levels_ ? key[0] : _new_block(history);
+    }
+    T keys[max_keys + 1];
+    int n = _decode(blk, keys);
+    int pos = int(std::upper_bound(keys, keys + n, value) - keys);
+    std::copy_backward(keys + pos, keys + n, keys + n + 1);
+    keys[pos] = value;
+    ++n;
+    ++size_;
+
+    int bytes = _packed_size(keys, n);
+    if(bytes <= B) {
+        _encode(blk, keys, n);
+        return;
+    }
+    // split where the differences divide in two.
+    // the key at the split loses its difference, it starts the new block
+    int split = 1, left = 0;
+    for(;;) {
+        int next = _sl_varint_size(_delta(keys[split - 1], keys[split]));
+        if(split == n - 1 || left + next >= bytes / 2)
+            break;
+        left += next;
+        ++split;
+    }
+    // the new block goes right after blk, which is on the path
+    // up to its own height
+    for(int level = 0; level < blk->height; ++level)
+        history[level] = blk;
+    SLPackedBlock<T, B> *right = _new_block(history);
+    _encode(blk, keys, split);
+    _encode(right, keys + split, n - split);
+}
+
+template<typename T, typename L, typename A, int B>
+// Cannot assume element exists
+void int_skiplist<T, L, A, B>::erase(T value) {
+    SLPackedBlock<T, B> *history[L::max_level];
+    // blocks after this one start past value,
+    // so if value is anywhere, it is in here
+    SLPackedBlock<T, B> *blk = _upper_path(value, history);
+    if(!blk || blk->last < value)
+        return;
+    T keys[max_keys + 1];
+    int n = _decode(blk, keys);
+    int pos = int(std::upper_bound(keys, keys + n, value) - keys) - 1;
+    if(keys[pos] != value)
+        return;
+    _erase_at(blk, keys, n, pos);
+}
+
+template<typename T, typename L, typename A, int B>
+// Assume that iterator is valid
+// After erasing, move on to the next element
+typename int_skiplist<T, L, A, B>::iterator
+int_skiplist<T, L, A, B>::erase(typename int_skiplist<T, L, A, B>::iterator it) {
+    SLPackedBlock<T, B> *blk = const_cast<SLPackedBlock<T, B>*>(it.blk_);
+    T keys[max_keys + 1];
+    int n = _decode(blk, keys);
+    return _erase_at(blk, keys, n, it.pos_);
+}
+
+template<typename T, typename L, typename A, int B>
+typename int_skiplist<T, L, A, B>::iterator
+int_skiplist<T, L, A, B>::find(T value) const {
+    if(!levels_)
+        return end();
+    // the first key not less than value is in the last block
+    // starting before value, or first thing in the block after it
+    const SLPackedBlock<T, B> *blk = _lower_block(value);
+    if(!blk)
+        blk = key[0];
+    else if(blk->last < value)
+        blk = blk->next[0];
+    iterator it(this, blk);
+    while(it.blk_ == blk && blk && *it < value)
+        it._forward();
+    if(it == end() || *it != value)
+        return end();
+    return it;
+}
+// End of cpp file
+
+#endif
+// End of header file
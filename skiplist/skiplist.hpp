@@ -6,85 +6,477 @@ Only the skiplist container should be visible
 #define SKIPLIST_H
 #include <vector>
 #include <map>
+#include <algorithm>
+#include <string>
+#include <cstdint>
+#include <cstring>
 #include <unordered_map>
 #include <random>
 #include <iterator>
 #include <initializer_list>
+#include <new>
+#include <memory>
+#include <utility>
+#include <type_traits>
 
 #include <iomanip>
 #include <iostream>
 
+#include "skiplist_pool.hpp"
+#include "skiplist_level.hpp"
+#include "skiplist_index.hpp"
+#include "skiplist_compare.hpp"
+#include "skiplist_range.hpp"
+
+// Should forward links carry a copy of the key they point to?
+// On for small keys that are cheap to copy around, specialize to change that
+template<typename T>
+struct SLCacheKeys {
+    static const bool value = std::is_trivially_copyable<T>::value
+        && std::is_default_constructible<T>::value && sizeof(T) <= 8;
+};
+
+// A forward link, behaves like the pointer it holds.
+// With Cached, it also keeps a copy of the key of the node it points to,
+// so a search can decide whether to go right or down from the node it
+// is standing on, without pulling the next one into cache.
+template<typename Node, typename T, bool Cached>
+struct SLLink {
+    Node *node;
+    SLLink(Node *node_ = nullptr) : node(node_) {}
+    operator Node*() const { return node; }
+    Node *operator->() const { return node; }
+    // key of the node pointed to, which must exist
+    const T &key() const { return node->val; }
+};
+
+template<typename Node, typename T>
+struct SLLink<Node, T, true> {
+    Node *node;
+    T cached;
+    SLLink(Node *node_ = nullptr) : node(node_) {
+        if(node_)
+            cached = node_->val;
+    }
+    operator Node*() const { return node; }
+    Node *operator->() const { return node; }
+    const T &key() const { return cached; }
+};
+
+// first 8 bytes of a string as a big-endian number, zero padded.
+// Two strings whose prefixes differ compare like their prefixes do,
+// as far as std::char_traits<char> (which compares bytes unsigned) goes
+template<typename S>
+std::uint64_t _sl_string_prefix(const S &s) {
+    unsigned char bytes[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    std::memcpy(bytes, s.data(), s.size() < 8 ? s.size() : 8);
+    std::uint64_t prefix = 0;
+    for(int i=0; i<8; i++)
+        prefix = prefix << 8 | bytes[i];
+    return prefix;
+}
+
+// ask for the cache line at p ahead of a load from it
+inline void _sl_prefetch(const void *p) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(p);
+#else
+    (void)p;
+#endif
+}
+
+// Can a search order T with Compare by prefixes, see SLLink below?
+// On for std::string (with any allocator) in its usual order
+template<typename T, typename Compare>
+struct SLKeyPrefix {
+    static const bool value = false;
+};
+
+template<typename A>
+struct SLKeyPrefix<std::basic_string<char, std::char_traits<char>, A>,
+                   std::less<std::basic_string<char, std::char_traits<char>, A> > > {
+    static const bool value = true;
+};
+
+#if __cplusplus >= 201402L
+template<typename A>
+struct SLKeyPrefix<std::basic_string<char, std::char_traits<char>, A>, std::less<> > {
+    static const bool value = true;
+};
+#endif
+
+// A cached link to a string keeps the prefix of the string instead of
+// a copy of it. When the prefixes of the string and the one searched
+// for differ, that is the whole comparison: the search neither loads
+// the node nor follows the string to its characters.
+// Only prefix ties need the strings themselves
+template<typename Node, typename A>
+struct SLLink<Node, std::basic_string<char, std::char_traits<char>, A>, true> {
+    using string_t = std::basic_string<char, std::char_traits<char>, A>;
+    Node *node;
+    std::uint64_t prefix;
+    SLLink(Node *node_ = nullptr) : node(node_), prefix(node_ ? _sl_string_prefix(node_->val) : 0) {}
+    operator Node*() const { return node; }
+    Node *operator->() const { return node; }
+    const string_t &key() const { return node->val; }
+    // -1, 0 or 1 as the string pointed to is less than, equal to or
+    // greater than value, whose prefix is value_prefix
+    int order(const string_t &value, std::uint64_t value_prefix) const {
+        if(prefix != value_prefix)
+            return prefix < value_prefix ? -1 : 1;
+        int order = node->val.compare(value);
+        return (order > 0) - (order < 0);
+    }
+};
+
+// How a node keeps the elements equal to its own.
+// SLStoredDups keeps every one of them, since equal is not always the
+// same. The first is the node's own val, the others go in a vector on
+// the side, which only gets allocated once there is a second one.
+// SLCountedDups keeps nothing but the count, every copy reads as val.
+struct SLStoredDups {};
+struct SLCountedDups {};
+
+template<typename T, typename Alloc, typename Dups>
+struct SLDupStore;
+
+template<typename T, typename Alloc>
+struct SLDupStore<T, Alloc, SLStoredDups> {
+    using vector_t = std::vector<T, Alloc>;
+    using vector_alloc_t = typename std::allocator_traits<Alloc>::template rebind_alloc<vector_t>;
+    using vector_traits = std::allocator_traits<vector_alloc_t>;
+
+    // every copy after the first, nullptr while there is just the one
+    vector_t *more;
+
+    SLDupStore() : more(nullptr) {}
+    SLDupStore(const SLDupStore &) = delete;
+    SLDupStore &operator=(const SLDupStore &) = delete;
+    ~SLDupStore() { clear(); }
+
+    // copy number i, val being the first
+    const T &at(const T &val, int i) const { return i ? (*more)[i - 1] : val; }
+
+    void push(const T &value, const Alloc &alloc) {
+        if(!more)
+            more = new(_allocate(alloc)) vector_t(alloc);
+        more->push_back(value);
+    }
+    void push(T &&value, const Alloc &alloc) {
+        if(!more)
+            more = new(_allocate(alloc)) vector_t(alloc);
+        more->push_back(std::move(value));
+    }
+    // drop the most recent copy, which must not be val
+    void pop() {
+        more->pop_back();
+        if(more->empty())
+            clear();
+    }
+    // drop copies from up to to, in the order they came, leaving at
+    // least one. When val goes the first copy left takes its place
+    void erase(T &val, int from, int to) {
+        if(!from) {
+            val = std::move((*more)[to - 1]);
+            ++from;
+            ++to;
+        }
+        more->erase(more->begin() + (from - 1), more->begin() + (to - 1));
+        if(more->empty())
+            clear();
+    }
+    void copy(const SLDupStore &other, const Alloc &alloc) {
+        if(other.more)
+            more = new(_allocate(alloc)) vector_t(*other.more, alloc);
+    }
+    // move every copy of another node over, its val first, after ours
+    void take(T &&val, SLDupStore &other, const Alloc &alloc) {
+        push(std::move(val), alloc);
+        if(other.more)
+            for(T &value : *other.more)
+                more->push_back(std::move(value));
+    }
+    // the vector was made with its own allocator, so it can free itself
+    void clear() {
+        if(!more)
+            return;
+        vector_alloc_t alloc(more->get_allocator());
+        more->~vector_t();
+        vector_traits::deallocate(alloc, more, 1);
+        more = nullptr;
+    }
+
+private:
+    static vector_t *_allocate(const Alloc &alloc) {
+        vector_alloc_t vector_alloc(alloc);
+        return vector_traits::allocate(vector_alloc, 1);
+    }
+};
+
+template<typename T, typename Alloc>
+struct SLDupStore<T, Alloc, SLCountedDups> {
+    const T &at(const T &val, int) const { return val; }
+    void push(const T &, const Alloc &) {}
+    void push(T &&, const Alloc &) {}
+    void pop() {}
+    void erase(T &, int, int) {}
+    void copy(const SLDupStore &, const Alloc &) {}
+    void take(T &&, SLDupStore &, const Alloc &) {}
+};
+
+// Tag for building a list from input that is already sorted, like
+//   skiplist<int> s(sl_from_sorted, v.begin(), v.end());
+// which links every tower in as it comes, in one pass and without a
+// single search. Equal elements must be next to each other.
+// With sl_from_sorted_ideal the towers are spaced out evenly instead of
+// getting random heights, see ideal_height in skiplist_level.hpp
+struct SLFromSorted {
+    bool ideal;
+};
+const SLFromSorted sl_from_sorted = {false};
+const SLFromSorted sl_from_sorted_ideal = {true};
+
 template<
     typename val_type,
-    typename compare_t = std::less<val_type>
+    typename compare_t = std::less<val_type>,
+    typename level_t = SLHalfLevels<>,
+    typename alloc_t = std::allocator<val_type>,
+    bool cache_keys = SLCacheKeys<val_type>::value || SLKeyPrefix<val_type, compare_t>::value,
+    typename dups_t = SLStoredDups
 >
 class skiplist;
 
 template<
     typename val_type,
-    typename compare_t
+    typename compare_t,
+    typename level_t,
+    typename alloc_t,
+    bool cache_keys,
+    typename dups_t
 >
-std::ostream &operator<<(std::ostream &out, const skiplist<val_type, compare_t>&);
+std::ostream &operator<<(std::ostream &out, const skiplist<val_type, compare_t, level_t, alloc_t, cache_keys, dups_t>&);
 
-template<typename T>
+template<typename T, typename Alloc = std::allocator<T>, bool Cached = false,
+         typename Dups = SLStoredDups>
 struct SLNode {
-    // Poorly named - left, right, up, down pointers
-    SLNode *back, *next, *up, *down;
+    using link = SLLink<SLNode, T, Cached>;
+
+    // left pointer, only kept at level 0 since that is all iterators need
+    SLNode *back;
     // Value, should be templated
     T val;
-    // Storage for multiple elements
-    std::vector<T> valz;
-    // Count is integer only, will only be 0 for key nodes
+    // Storage for the other elements equal to val, see SLDupStore
+    SLDupStore<T, Alloc, Dups> dups;
+    // Count is integer only
     int count;
-    SLNode(T val_)
-    : back(nullptr), next(nullptr), up(nullptr), down(nullptr), val(val_), count(1) {}
-    // TODO: not nice, T must have default constructor, must figure a workaround
-    SLNode()
-    : back(nullptr), next(nullptr), up(nullptr), down(nullptr), count(0) {}
-    
-    // Special copy constructor
-    SLNode(SLNode other, int)
-    : back(nullptr), next(nullptr), up(nullptr), down(nullptr), valz(other.valz) {
-        val = other.val;
-        count = other.count;
+    // number of levels this tower spans
+    int height;
+    // forward pointers, one per level.
+    // The node is over-allocated so that this holds `height` entries,
+    // the whole tower is a single allocation (same trick as leveldb)
+    link next[1];
+
+    // build a tower of height_ levels with memory from the pool,
+    // its val constructed in place from args
+    template<typename Pool, typename... Args>
+    static SLNode *create(Pool &pool, int height_, Args&&... args) {
+        void *mem = pool.allocate(height_);
+        return new(mem) SLNode(height_, std::forward<Args>(args)...);
+    }
+    template<typename Pool>
+    static void destroy(Pool &pool, SLNode *node) {
+        int height_ = node->height;
+        node->~SLNode();
+        pool.deallocate(node, height_);
+    }
+    // size of a tower with height_ levels
+    static std::size_t bytes(int height_) {
+        return sizeof(SLNode) + (height_ - 1) * sizeof(link);
+    }
+
+private:
+    template<typename... Args>
+    explicit SLNode(int height_, Args&&... args)
+    : back(nullptr), val(std::forward<Args>(args)...), count(1), height(height_) {
+        for(int i=0; i<height_; i++)
+            next[i] = nullptr;
     }
 };
 
 template<
     typename val_type,
-    typename compare_t
+    typename compare_t,
+    typename level_t,
+    typename alloc_t,
+    bool cache_keys,
+    typename dups_t
 >
 class skiplist {
 private:
-    // header nodes for all levels
-    std::vector<SLNode<val_type>*> key;
-    // number of nodes in the skiplist (including non-unique ones)
-    int size_;
+    using alloc_traits = std::allocator_traits<alloc_t>;
+    using node_alloc_t = typename alloc_traits::template rebind_alloc<val_type>;
+    using link_t = typename SLNode<val_type, alloc_t, cache_keys, dups_t>::link;
+    using key_alloc_t = typename alloc_traits::template rebind_alloc<link_t>;
+    using tail_alloc_t = typename alloc_traits::template rebind_alloc<SLNode<val_type, alloc_t, cache_keys, dups_t>*>;
+
+    // forward pointers out of the header, one per level.
+    // key[i] is the first node at level i
+    std::vector<link_t, key_alloc_t> key;
     // the last node at level 0
-    SLNode<val_type>* last;
+    SLNode<val_type, alloc_t, cache_keys, dups_t>* last;
+    // the last tower on every level, nullptr for an empty one.
+    // side by side with key, tail[0] is last
+    std::vector<SLNode<val_type, alloc_t, cache_keys, dups_t>*, tail_alloc_t> tail;
+    // every tower lives in here
+    SLNodePool<SLNode<val_type, alloc_t, cache_keys, dups_t>, level_t::max_level, node_alloc_t> pool_;
+    // sorted copy of one of the top levels, see skiplist_index.hpp
+    SLTopIndex<SLNode<val_type, alloc_t, cache_keys, dups_t>, val_type, alloc_t, level_t::max_level,
+               SLDenseIndex<val_type, compare_t>::value> index_;
+
+    // random numbers for tower heights, seeded on first use
+    SLRandom rng_;
+    // predecessors of the last value searched for on every level,
+    // in finger mode only, see set_finger
+    SLNode<val_type, alloc_t, cache_keys, dups_t> **finger_ = nullptr;
+
+    // template objects, since compare is supposed to be a functor.
+    // wrapped so that three-way comparators work too, see skiplist_compare.hpp
+    SLCompare<compare_t> compare;
+    // picks the height of new towers, see skiplist_level.hpp
+    level_t levels;
+    // number of nodes in the skiplist (including non-unique ones).
+    // after the two empty functors, so it shares their word
+    int size_;
 
-    // stuff required for random number generation
-    // see constructor for description/reference
-    std::mt19937_64 mt_;
-    std::uniform_real_distribution<double> dist_;
+    // do searches for a val_type go by the prefixes in the links
+    static const bool prefixed_ = cache_keys && SLKeyPrefix<val_type, compare_t>::value;
+    using prefix_tag = std::integral_constant<bool, prefixed_>;
+
+    // -1, 0 or 1 as the tower a link points to is less than, equal to
+    // or greater than value. value_prefix is what _prefix gave for value
+    template<typename K>
+    int _order(const typename SLNode<val_type, alloc_t, cache_keys, dups_t>::link &l, const K &value,
+               std::uint64_t, std::false_type) const {
+        return compare.order(l.key(), value);
+    }
+    int _order(const typename SLNode<val_type, alloc_t, cache_keys, dups_t>::link &l, const val_type &value,
+               std::uint64_t value_prefix, std::true_type) const {
+        return l.order(value, value_prefix);
+    }
+    template<typename K>
+    static std::uint64_t _prefix(const K &, std::false_type) { return 0; }
+    static std::uint64_t _prefix(const val_type &value, std::true_type) { return _sl_string_prefix(value); }
+    // is the tower a link points to less than value
+    bool _before(const link_t &l, const val_type &value, std::uint64_t value_prefix) const {
+        return prefixed_ ? _order(l, value, value_prefix, prefix_tag()) < 0 : compare(l.key(), value);
+    }
 
-    // template objects, since compare is supposed to be a functor
-    compare_t compare;
+    // forward pointers leaving a node. nullptr stands in for the header
+    link_t *_links(SLNode<val_type, alloc_t, cache_keys, dups_t> *node) {
+        return node ? node->next : key.data();
+    }
 
-    // setup random number generator and uniform
-    // distribution to help with probabilistic
-    // insertion.
-    void _setup_random_number_generator() {
-        // set up random number generator
-        // ref: https://stackoverflow.com/a/19666713/11199009
-        std::random_device rd;
-        // ref: https://www.cplusplus.com/reference/random/mt19937_64/
-        std::mt19937_64 mt(rd());
-        // usage of this is: dist(mt)
-        std::uniform_real_distribution<double> dist(0.0, 1.0);
+    // height of a new tower, as the level policy sees fit.
+    // never more than the policy thinks is useful for the current size
+    int _random_height() {
+        int height = levels(rng_), limit = level_t::level_limit(size_);
+        return height < limit ? height : limit;
+    }
 
-        this->mt_ = mt;
-        this->dist_ = dist;
+    // walk down from the top of the header, filling history with the
+    // last node before value at every level (nullptr for the header).
+    // returns the first node not less than value at level 0,
+    // and whether it is equal to value in equal, if given.
+    // Unless full, the walk starts from the index, which only fills
+    // the bottom _quick_levels() of history
+    SLNode<val_type, alloc_t, cache_keys, dups_t> *_find_path(const val_type &value, SLNode<val_type, alloc_t, cache_keys, dups_t> **history, bool full = false, bool *equal = nullptr);
+
+    // _find_path for a value not less than the one history was last
+    // filled for, on every level. Climbs from level 0 only as long as the
+    // tower after history is still less than value, then walks down
+    // from there, which is O(log d) for d towers between the two values.
+    // either_way also lets value be less than the last one, at a compare
+    // more per level climbed
+    SLNode<val_type, alloc_t, cache_keys, dups_t> *_finger_path(const val_type &value, SLNode<val_type, alloc_t, cache_keys, dups_t> **history, bool *equal, bool either_way = false);
+    // forget the finger path, after the towers changed without it
+    void _finger_reset() {
+        if(finger_)
+            for(int i=0; i<level_t::max_level; i++)
+                finger_[i] = nullptr;
+    }
+
+    // levels of history a quick _find_path fills
+    int _quick_levels() const {
+        return index_.built() && index_.level() < (int)key.size() ? index_.level() + 1 : (int)key.size();
+    }
+
+    // keep the index in step with the towers. Every tower that is linked
+    // in goes through _index_add, every one unlinked through _index_remove
+    void _index_add(SLNode<val_type, alloc_t, cache_keys, dups_t> *node);
+    void _index_remove(SLNode<val_type, alloc_t, cache_keys, dups_t> *node);
+    // count the towers and index the right level, from scratch
+    void _index_build();
+    // hist[h] towers of height h + 1, from the counts of the index if
+    // it is built, otherwise counted along level 0
+    void _index_towers(int *hist);
+    // index the right level for the towers in hist, from scratch
+    void _index_from(const int *hist);
+    // index the towers of another level
+    void _index_fill(int level);
+
+    // put a new tower in on every level it spans.
+    // history must hold its predecessors, as filled by _find_path
+    void _link_node(SLNode<val_type, alloc_t, cache_keys, dups_t> *node, SLNode<val_type, alloc_t, cache_keys, dups_t> **history);
+    // history for a value past the last element: the tails
+    SLNode<val_type, alloc_t, cache_keys, dups_t> **_tail_path(SLNode<val_type, alloc_t, cache_keys, dups_t> **history) {
+        for(int level = 0; level < (int)key.size(); ++level)
+            history[level] = tail[level];
+        return history;
+    }
+    // most towers _hint_path walks back over
+    static const int hint_steps = 16;
+    // history on the bottom levels for a new tower right before next
+    // (nullptr for the end), taken from the towers before it on level 0:
+    // the first one tall enough for a level is the predecessor there.
+    // false if that takes more than hint_steps towers
+    bool _hint_path(SLNode<val_type, alloc_t, cache_keys, dups_t> *next, int levels, SLNode<val_type, alloc_t, cache_keys, dups_t> **history);
+    // does value go right before next? equal is then the tower
+    // value is equal to, or nullptr if it needs a new one
+    bool _at_hint(SLNode<val_type, alloc_t, cache_keys, dups_t> *next, const val_type &value, SLNode<val_type, alloc_t, cache_keys, dups_t> *&equal);
+    // link a new tower in right before next
+    void _link_hint(SLNode<val_type, alloc_t, cache_keys, dups_t> *next, SLNode<val_type, alloc_t, cache_keys, dups_t> *node);
+    // insert a copy of value, or value itself if it is an rvalue
+    template<typename U>
+    void _insert(U &&value);
+    // insert_batch and erase_batch on sorted input
+    template<typename InputIterator>
+    void _insert_sorted(InputIterator first, InputIterator end);
+    template<typename InputIterator>
+    void _erase_sorted(InputIterator first, InputIterator end);
+    // fill an empty list from sorted input, see SLFromSorted
+    template<typename InputIterator>
+    void _build_sorted(InputIterator first, InputIterator end, bool ideal);
+    // fill an empty list from any input. input that can be gone over
+    // twice is checked first, and built in one pass if it is sorted
+    template<typename InputIterator>
+    void _build(InputIterator first, InputIterator end, std::input_iterator_tag);
+    template<typename ForwardIterator>
+    void _build(ForwardIterator first, ForwardIterator end, std::forward_iterator_tag);
+
+    // unlink a tower from every level and free it.
+    // history must hold its predecessors, as filled by _find_path
+    void _remove_node(SLNode<val_type, alloc_t, cache_keys, dups_t> *node, SLNode<val_type, alloc_t, cache_keys, dups_t> **history);
+
+    // link the levels of other after ours, everything in other being
+    // greater, and take its towers over
+    void _append(skiplist &other);
+    // trade levels with other, towers stay with their pools
+    void _swap_levels(skiplist &other) {
+        std::swap(key, other.key);
+        std::swap(tail, other.tail);
+        std::swap(size_, other.size_);
+        std::swap(last, other.last);
+        std::swap(index_, other.index_);
     }
 
 public:
@@ -99,51 +491,71 @@ public:
     using const_reverse_iterator = cake_iterator<true>;
     using reverse_iterator = const_reverse_iterator;
 
-    skiplist() : size_(0), last(nullptr) {_setup_random_number_generator();}
+    skiplist() : last(nullptr), size_(0) {}
+
+    // every node, the key and the duplicate stores come out of alloc
+    explicit skiplist(const alloc_t &alloc)
+    : key(key_alloc_t(alloc)), last(nullptr), tail(tail_alloc_t(alloc)), pool_(node_alloc_t(alloc)), size_(0) {}
 
     // iterator range is assumed to be valid.
     // can we validate range? no need, screw the user :)
+    // sorted input is spotted and built in one pass, like sl_from_sorted
     template<typename InputIterator>
-    skiplist(InputIterator first, InputIterator last): size_(0), last(nullptr) {
-        _setup_random_number_generator();
+    skiplist(InputIterator first, InputIterator last, const alloc_t &alloc = alloc_t())
+    : key(key_alloc_t(alloc)), last(nullptr), tail(tail_alloc_t(alloc)), pool_(node_alloc_t(alloc)), size_(0) {
         // last and size_ are taken care of during insertion.
-        while(first != last) {
-            insert(*first);
-            ++first;
-        }
+        _build(first, last, typename std::iterator_traits<InputIterator>::iterator_category());
     }
 
-    skiplist(std::initializer_list<val_type> l) : size_(0), last(nullptr) {
-        _setup_random_number_generator();
-        auto first = l.begin();
-        auto last = l.end();
-        while(first != last) {
-            insert(*first);
-            ++first;
-        }
+    skiplist(std::initializer_list<val_type> l, const alloc_t &alloc = alloc_t())
+    : key(key_alloc_t(alloc)), last(nullptr), tail(tail_alloc_t(alloc)), pool_(node_alloc_t(alloc)), size_(0) {
+        _build(l.begin(), l.end(), std::random_access_iterator_tag());
     }
 
-    // At every level, go on till nullptr and delete everything in its path
-    // then go on to the upper level
+    // input must be sorted, see SLFromSorted
+    template<typename InputIterator>
+    skiplist(SLFromSorted how, InputIterator first, InputIterator last, const alloc_t &alloc = alloc_t())
+    : key(key_alloc_t(alloc)), last(nullptr), tail(tail_alloc_t(alloc)), pool_(node_alloc_t(alloc)), size_(0) {
+        _build_sorted(first, last, how.ideal);
+    }
+
+    // Every tower shows up exactly once at level 0
+    // so walking that level runs every destructor.
+    // The memory itself goes back in one sweep over the slabs
     void destroy_all_levels() {
-        SLNode<val_type> *tmp;
-        for(auto level: key)
-            while(level) {
-                tmp = level->next;
-                delete level;
-                level = tmp;
-            }
+        SLNode<val_type, alloc_t, cache_keys, dups_t> *tmp, *level = key.empty() ? nullptr : key[0];
+        while(level) {
+            tmp = level->next[0];
+            if(pool_.from_heap(level->height))
+                SLNode<val_type, alloc_t, cache_keys, dups_t>::destroy(pool_, level);
+            else
+                level->~SLNode();
+            level = tmp;
+        }
+        pool_.release();
+        index_.destroy(get_allocator());
         key.clear();
+        tail.clear();
+        last = nullptr;
+        _finger_reset();
     }
     
-    ~skiplist() { destroy_all_levels(); }
+    ~skiplist() {
+        destroy_all_levels();
+        set_finger(false);
+    }
 
     // move constructor
     skiplist(skiplist &&other) 
-    : key(other.key), size_(other.size_), last(other.last) {
-        _setup_random_number_generator();
+    : key(std::move(other.key)), last(other.last), tail(std::move(other.tail)),
+      pool_(std::move(other.pool_)), index_(std::move(other.index_)), rng_(other.rng_),
+      finger_(other.finger_), size_(other.size_) {
         // thief! thief! resources gon :(
+        other.finger_ = nullptr;
         other.key.clear();
+        other.tail.clear();
+        other.size_ = 0;
+        other.last = nullptr;
     }
 
     // move assignment. Apparently, this cannot be a friend :(
@@ -153,15 +565,34 @@ public:
         // what have you bought upon this cursed land?
             return *this;
 
-        // Ruthlessly STEAAAAL
         destroy_all_levels();
-        key = rhs.key;
+        // the finger path comes from the allocator, which may change hands
+        const bool had_finger = finger();
+        set_finger(false);
+        // Nodes can only change hands if our allocator can free them
+        if(!alloc_traits::propagate_on_container_move_assignment::value
+           && get_allocator() != rhs.get_allocator()) {
+            perform_key_transfer(rhs);
+            size_ = rhs.size_;
+            rhs.destroy_all_levels();
+            rhs.size_ = 0;
+            set_finger(had_finger);
+            return *this;
+        }
+
+        // Ruthlessly STEAAAAL
+        key = std::move(rhs.key);
+        tail = std::move(rhs.tail);
         size_ = rhs.size_;
         last = rhs.last;
+        pool_ = std::move(rhs.pool_);
+        index_ = std::move(rhs.index_);
 
         rhs.key.clear();
+        rhs.tail.clear();
         rhs.size_ = 0;
         rhs.last = nullptr;
+        set_finger(had_finger);
 
         return *this;
     }
@@ -171,64 +602,38 @@ public:
     void perform_key_transfer(const skiplist &other) {
         if(other.key.empty())
             return;
-        
-        // map node pointers through s p a c e. has info about ...
-        // which node of L (i.e LHS) is holding the node from R (i.e. RHS)
-        // useful to map horizontal pointers between two levels
-        std::unordered_map<SLNode<val_type>*, SLNode<val_type>*> twister, jenga;
-        SLNode<val_type> *trav_r, *trav_l;
-        // handy, because all level 0 nodes have a down pointer to nullptr
-        jenga[nullptr] = nullptr;
-
-        // map level 0
-        // now map the higher levels
-        // oh chuck, just map them all
-        for(int i=0; i<other.key.size(); i++) {
-            
-            trav_r = other.key[i]->next;
-            trav_l = new SLNode<val_type>();
-            key.push_back(trav_l);
-            while(trav_r) {
-                trav_l->next = new SLNode<val_type>(*trav_r, 15081947);
-                trav_l->next->back = trav_l;
-                trav_l = trav_l->next;
-                
-                twister[trav_r] = trav_l;
-                // my favourite exit strategy :)
-                if(jenga.find(trav_r->down)==jenga.end()) {
-                    std::cout << "Should never see here! In Copy constructor\n";
-                    std::cout.flush();
-                    int *x(nullptr);
-                    *x = *x;
-                }
-                // continue with normal execution
-                trav_l->down = jenga[trav_r->down];
-                
-                if(trav_l->down)
-                    trav_l->down->up = trav_l;
-                
-                trav_r = trav_r->next;
-            }
-            // special case for level 0. need to get the last node pointer
-            if(i==0)
-                last = twister[other.last];
 
-            // move the current level pointers to the prev-level-pointer store
-            jenga = twister;
-            twister.clear();
-        }
-        // properly interleave the up down nodes of the key stack
-        for(int i=1; i<key.size(); i++) {
-            key[i]->down = key[i-1];
-            key[i-1]->up = key[i];
+        key.assign(other.key.size(), nullptr);
+        // towers are copied in level 0 order, so each one just gets
+        // appended to the levels it spans, after their tails
+        tail.assign(other.key.size(), nullptr);
+        SLNode<val_type, alloc_t, cache_keys, dups_t> *trav_r, *trav_l;
+        for(trav_r = other.key[0]; trav_r; trav_r = trav_r->next[0]) {
+            trav_l = SLNode<val_type, alloc_t, cache_keys, dups_t>::create(pool_, trav_r->height, trav_r->val);
+            trav_l->dups.copy(trav_r->dups, get_allocator());
+            trav_l->count = trav_r->count;
+            trav_l->back = tail[0];
+            for(int i=0; i<trav_l->height; i++) {
+                _links(tail[i])[i] = trav_l;
+                tail[i] = trav_l;
+            }
         }
+        last = tail[0];
+        if(other.index_.built())
+            _index_build();
     }
 
     // copy constructor
     skiplist(const skiplist &other) 
-    : size_(other.size_) {
-        _setup_random_number_generator();
+    : skiplist(other, alloc_traits::select_on_container_copy_construction(
+                          other.get_allocator())) {}
+
+    // copy constructor, with an allocator of our own
+    skiplist(const skiplist &other, const alloc_t &alloc)
+    : key(key_alloc_t(alloc)), last(nullptr), tail(tail_alloc_t(alloc)),
+      pool_(node_alloc_t(alloc)), size_(other.size_) {
         perform_key_transfer(other);
+        set_finger(other.finger());
     }
 
     // copy assignment operator
@@ -242,59 +647,248 @@ public:
         destroy_all_levels();
         perform_key_transfer(rhs);
         size_ = rhs.size_;
-        last = rhs.last;
 
         return *this;
     }
 
     // specialized functions
-    void insert(val_type value);
+    // the search goes by reference, the element is only copied
+    // (or moved) once, into the tower or next to an equal one
+    void insert(const val_type &value) { _insert(value); }
+    void insert(val_type &&value) { _insert(std::move(value)); }
+    // build the element right in a new tower, from args,
+    // then link that tower in where the element belongs.
+    // returns an iterator to the new element
+    template<typename... Args>
+    iterator emplace(Args&&... args);
+    // with a hint: if the element goes right before hint, its tower
+    // gets linked in from there (or from the tails, for end()) in
+    // O(1) expected, without a search. A wrong hint costs two
+    // compares, then it is a normal insert.
+    // returns an iterator to the new element
+    iterator insert(const_iterator hint, const val_type &value) { return _insert_hint(hint, value); }
+    iterator insert(const_iterator hint, val_type &&value) { return _insert_hint(hint, std::move(value)); }
+    template<typename... Args>
+    iterator emplace_hint(const_iterator hint, Args&&... args);
+
+    // insert or erase a whole batch in one pass from left to right.
+    // every element starts its search where the one before it ended,
+    // so a batch of k spread over n elements costs about O(log(n/k))
+    // per element instead of O(log n). The batch is sorted first
+    // (into a copy) unless it already is
+    template<typename InputIterator>
+    void insert_batch(InputIterator first, InputIterator last);
+    template<typename InputIterator>
+    void erase_batch(InputIterator first, InputIterator last);
 
     // erase can be overloaded
     // this version finds the value and deletes the node if it exists
     // one more version of erase is passing an iterator object
-    void erase(val_type value);
+    void erase(const val_type &value);
     iterator erase(iterator it);
+    // erase [first, last), returns last. The towers in between come out
+    // of every level with one splice per level and are freed after,
+    // which is O(log n + k) for k towers
+    iterator erase(const_iterator first, const_iterator last);
+    // erase every element in [lo, hi), returns how many went
+    int erase_range(const val_type &lo, const val_type &hi) { return _erase_range(lo, hi); }
+    template<typename K, typename X = compare_t, typename = typename X::is_transparent>
+    int erase_range(const K &lo, const K &hi) { return _erase_range(lo, hi); }
+    // with a transparent compare_t (one that has is_transparent, like
+    // std::less<>), lookups take anything compare_t can compare with
+    // val_type, so no val_type has to be built just to search for it.
+    // this one removes the most recent element equal to value
+    template<typename K, typename X = compare_t, typename = typename X::is_transparent>
+    void erase(const K &value) {
+        auto it = find(value);
+        if(it != end())
+            erase(it);
+    }
 
-    iterator find(val_type value);
+    // Lists can trade towers without copying them, as long as their
+    // allocators are equal. The towers stay where they are in memory and
+    // the pools pass their slabs on, see SLNodePool::adopt and share.
+    // Iterators to the elements that moved now belong to the other list.
+    //
+    // move every element not less than value to a new list and return it.
+    // Every level is cut once after the path to value, which is O(log n),
+    // but the list keeps no counts per link, so the sizes of the halves
+    // take a walk over the smaller one along level 0. That makes it
+    // O(log n + min(k, n - k)) for k elements moved: cheap near either
+    // end, about half a list walk when cutting a big list in the middle
+    skiplist split(const val_type &value);
+    // move every element of other in here, leaving it empty. When all of
+    // other comes before or after this list, their levels are linked end
+    // to end in O(log n). Otherwise, or with unequal allocators, it is a merge
+    void join(skiplist &other);
+    void join(skiplist &&other) { join(other); }
+    // move every element of other in here, leaving it empty. Its towers
+    // are relinked in order, each searched for from the path of the one
+    // before, about O(log(n/m)) per tower for m of them. Elements equal
+    // to ones here go after those. With unequal allocators the elements
+    // are copied over instead
+    void merge(skiplist &other);
+    void merge(skiplist &&other) { merge(other); }
+
+    iterator find(const val_type &value) {
+        if(!finger_)
+            return _find(value);
+        bool equal;
+        SLNode<val_type, alloc_t, cache_keys, dups_t> *found = _finger_path(value, finger_, &equal, true);
+        return equal ? iterator(found) : end();
+    }
+    template<typename K, typename X = compare_t, typename = typename X::is_transparent>
+    iterator find(const K &value) { return _find(value); }
     // smol count function to match set interface
 
-    int count(val_type value) {
+    int count(const val_type &value) {
         auto it = find(value);
         return  it != end() ? it.node->count : 0;
     }
-    friend std::ostream &operator<<<val_type, compare_t>(std::ostream &out, const skiplist<val_type, compare_t>& sl);
+    template<typename K, typename X = compare_t, typename = typename X::is_transparent>
+    int count(const K &value) {
+        auto it = find(value);
+        return  it != end() ? it.node->count : 0;
+    }
+
+    // first element not less than value, end() if there is none
+    iterator lower_bound(const val_type &value) { return iterator(_bound(value, false)); }
+    template<typename K, typename X = compare_t, typename = typename X::is_transparent>
+    iterator lower_bound(const K &value) { return iterator(_bound(value, false)); }
+    // first element greater than value, end() if there is none
+    iterator upper_bound(const val_type &value) { return iterator(_bound(value, true)); }
+    template<typename K, typename X = compare_t, typename = typename X::is_transparent>
+    iterator upper_bound(const K &value) { return iterator(_bound(value, true)); }
+    // [lower_bound, upper_bound) of value with one search: equal
+    // elements share a tower, so the upper bound is right after it
+    std::pair<iterator, iterator> equal_range(const val_type &value) { return _equal_range(value); }
+    template<typename K, typename X = compare_t, typename = typename X::is_transparent>
+    std::pair<iterator, iterator> equal_range(const K &value) { return _equal_range(value); }
+    // the elements in [lo, hi), for a range-for. See skiplist_range.hpp
+    SLRange<iterator> range(const val_type &lo, const val_type &hi) { return _range(lo, hi); }
+    template<typename K, typename X = compare_t, typename = typename X::is_transparent>
+    SLRange<iterator> range(const K &lo, const K &hi) { return _range(lo, hi); }
+
+    // lookups find_batch and count_batch keep going side by side
+    static const int batch_width = 32;
+    // find or count every value in [first, last), one result per value
+    // written to out in the same order. The lookups take a step each in
+    // turn, and each prefetches the tower it moves to, so while one waits
+    // for memory the others get on with theirs and their cache misses
+    // overlap. Pays off once the list is bigger than the cache
+    template<typename ForwardIterator, typename OutputIterator>
+    OutputIterator find_batch(ForwardIterator first, ForwardIterator last, OutputIterator out);
+    template<typename ForwardIterator, typename OutputIterator>
+    OutputIterator count_batch(ForwardIterator first, ForwardIterator last, OutputIterator out);
+    friend std::ostream &operator<<<val_type, compare_t, level_t, alloc_t, cache_keys, dups_t>(std::ostream &out, const skiplist<val_type, compare_t, level_t, alloc_t, cache_keys, dups_t>& sl);
     int size() { return size_;}
+    alloc_t get_allocator() const { return alloc_t(pool_.get_allocator()); }
+    // slabs and free towers held by the node pool
+    SLPoolStats pool_stats() const { return pool_.stats(); }
+
+    // Finger mode: find, count, insert and erase of a val_type start from
+    // the path the one before took, and climb only as high as they need
+    // to before walking down again. That is O(log d) for values d apart
+    // instead of O(log n), a win when values come in order or close
+    // together. Other changes to the list reset the path.
+    // Off by default, the path takes a pointer per level
+    void set_finger(bool on);
+    bool finger() const { return finger_ != nullptr; }
 
     // forward iterator to begin
-    iterator begin() { return key.empty() ? end() : iterator(key[0]->next); }
+    iterator begin() { return key.empty() ? end() : iterator(key[0]); }
     // forward iterator to one beyond last.
     iterator end() { return iterator(nullptr); };
     // reverse iterator pointing to last element
     reverse_iterator rbegin() { return reverse_iterator(last);}
-    // sneak trick -> if the list is empty, last will be a nullptr
-    // thus returning rbegin() is okay. it also provides good symmetry wrt begin
-    reverse_iterator rend() { return key.empty() ? rbegin() : reverse_iterator(key[0]);}
+    // the first node has no back pointer, so one beyond it is a nullptr
+    reverse_iterator rend() { return reverse_iterator(nullptr);}
     // constant forward iterator
-    const_iterator cbegin() { return key.empty() ? cend() : const_iterator(key[0]->next);}
+    const_iterator cbegin() { return key.empty() ? cend() : const_iterator(key[0]);}
     // constant forward iterator pointing to one beyond the last node
     const_iterator cend() { return const_iterator(nullptr); }
     // constant reverse iterator pointing to last element
     const_reverse_iterator crbegin() { return const_reverse_iterator(last); }
     // constant reverse iterator pointing to last one before the first node
-    const_reverse_iterator crend() {
-        return key.empty() ? crbegin() : const_reverse_iterator(key[0]); 
+    const_reverse_iterator crend() { return const_reverse_iterator(nullptr); }
+
+private:
+    // first element equal to value, value being anything compare
+    // takes on the right of val_type
+    template<typename K>
+    iterator _find(const K &value);
+    // insert with a hint, see insert(const_iterator, const val_type &)
+    template<typename U>
+    iterator _insert_hint(const_iterator hint, U &&value);
+    // first tower not less than value, or greater than it if upper
+    template<typename K>
+    SLNode<val_type, alloc_t, cache_keys, dups_t> *_bound(const K &value, bool upper);
+    template<typename K>
+    std::pair<iterator, iterator> _equal_range(const K &value);
+    // [lower_bound(lo), lower_bound(hi)), empty if hi comes first
+    template<typename K>
+    SLRange<iterator> _range(const K &lo, const K &hi) {
+        iterator first = lower_bound(lo), last = lower_bound(hi);
+        if(!first.node || (last.node && compare(last.node->val, first.node->val)))
+            last = first;
+        return SLRange<iterator>(first, last);
+    }
+    template<typename K>
+    int _erase_range(const K &lo, const K &hi) {
+        int before = size_;
+        SLRange<iterator> doomed = _range(lo, hi);
+        erase(doomed.first, doomed.last);
+        return before - size_;
+    }
+    // take copies from up to to of the ones in node out, at least one stays
+    void _drop_copies(SLNode<val_type, alloc_t, cache_keys, dups_t> *node, int from, int to) {
+        node->dups.erase(node->val, from, to);
+        node->count -= to - from;
+        size_ -= to - from;
+    }
+    // unlink the towers from first up to stop (nullptr for the end)
+    // from every level and free them
+    void _unlink_span(SLNode<val_type, alloc_t, cache_keys, dups_t> *first, SLNode<val_type, alloc_t, cache_keys, dups_t> *stop);
+    // put a tower made by emplace in, or its element next to an equal one
+    iterator _emplace_node(SLNode<val_type, alloc_t, cache_keys, dups_t> *node);
+    // the newest element equal to the one in node
+    iterator _newest(SLNode<val_type, alloc_t, cache_keys, dups_t> *node) {
+        iterator it(node);
+        for(int i=1; i<node->count; i++)
+            ++it;
+        return it;
     }
+
+    // where one lookup of find_batch has got to
+    struct batch_lookup_t {
+        link_t *links;
+        SLNode<val_type, alloc_t, cache_keys, dups_t> *stop;
+        std::uint64_t prefix;
+        int level;
+        // the next tower was prefetched and can be compared
+        bool ready;
+    };
+    // runs the lookups a batch_width at a time, emit gets the tower
+    // found for every value, nullptr if there is none
+    template<typename ForwardIterator, typename Emit>
+    void _find_batch(ForwardIterator first, ForwardIterator last, Emit emit);
+    // one step of a lookup, up to the next load that may miss the cache.
+    // false once it is done
+    bool _batch_step(batch_lookup_t &lookup, const val_type &value);
 };
 
 // Iterator always points to a level 0 node
 // or a nullptr for end()
 template<
     typename val_type, 
-    typename compare_t
+    typename compare_t,
+    typename level_t,
+    typename alloc_t,
+    bool cache_keys,
+    typename dups_t
 >
 template<bool reversal>
-class skiplist<val_type, compare_t>::cake_iterator {
+class skiplist<val_type, compare_t, level_t, alloc_t, cache_keys, dups_t>::cake_iterator {
 private:
     // since the skip list supports having non-unique elements with
     // the help of a count, to keep track of whether the iterator
@@ -314,9 +908,13 @@ private:
     // If true, the increment operations should move to node->back instead of node->next
     // Count calculations, technically, should not be affected I think
     bool reverse_;
-    // One edge case we need to take care of is a reverse ++ on the first node
-    // Instead of moving to nullptr, it will move to the key vector
-    // This is currently handled by rend and crend
+    // A reverse ++ on the first node moves to nullptr, since the first
+    // node has no back pointer. This is what rend and crend return
+
+    friend class skiplist;
+    // which of the node's elements this is, val being 0.
+    // an iterator that ran off the end keeps its old counts
+    int _index() const { return node ? node_count_ref_ - node_count_ : 0; }
 public:
     // types
     using difference_type = std::ptrdiff_t;
@@ -326,8 +924,8 @@ public:
     using iterator_category = std::bidirectional_iterator_tag;
     // To increment or decrement this iterator, just change node
     
-    SLNode<val_type> *node;
-    cake_iterator(SLNode<val_type> *node_) : node(node_) {
+    SLNode<val_type, alloc_t, cache_keys, dups_t> *node;
+    cake_iterator(SLNode<val_type, alloc_t, cache_keys, dups_t> *node_) : node(node_) {
         // check iterator constructor for explanation
         node_count_ = 0;
         node_count_ref_ = 0;
@@ -339,14 +937,14 @@ public:
         reverse_ = reversal;
     }
 
-    bool operator==(const cake_iterator &rhs) {
+    bool operator==(const cake_iterator &rhs) const {
         return node==rhs.node && node_count_ == rhs.node_count_;
     }
-    bool operator!=(const cake_iterator &rhs) { return !(*this==rhs); }
+    bool operator!=(const cake_iterator &rhs) const { return !(*this==rhs); }
     
     const val_type& operator*() const {
         // black magic. who's gonna read this anyway?
-        return node->valz[node_count_ref_ - node_count_];
+        return node->dups.at(node->val, node_count_ref_ - node_count_);
     }
     // pre-increment operator
     const cake_iterator& operator++() {
@@ -357,7 +955,7 @@ public:
         if(reverse_)
             node = node->back;
         else
-            node = node->next;
+            node = node->next[0];
         if(node) {
             node_count_ = node->count - 1;
             node_count_ref_ = node_count_;
@@ -378,7 +976,7 @@ public:
             return *this;
         }
         if(reverse_)
-            node = node->next;
+            node = node->next[0];
         else
             node = node->back;
         if(node) {
@@ -402,247 +1000,1040 @@ public:
 ================================================================================
 */
 
-// utility function to check equality, am lazy
-// https://twitter.com/acemarke/status/1072342186396667905
-template<typename T, typename op>
-bool _420_is_equal(T &a, T& b, op less_than) {
-    return !less_than(a, b) && !less_than(b, a);
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+SLNode<T, A, C, D> *skiplist<T, X, L, A, C, D>::_find_path(const T &value, SLNode<T, A, C, D> **history, bool full, bool *equal) {
+    // Search starts from the top of the header
+    SLNode<T, A, C, D> *follow = nullptr, *stop = nullptr;
+    // how the last tower that stopped the walk compares with value
+    int stop_order = 1;
+    // with prefixes or a three-way compare, one call tells all
+    const bool by_order = prefixed_ || compare.three_way;
+    const std::uint64_t value_prefix = _prefix(value, prefix_tag());
+    typename SLNode<T, A, C, D>::link *links = key.data();
+    int top = (int)key.size() - 1;
+    // or right where the index says it would have got to
+    if(!full && _quick_levels() <= top) {
+        top = index_.level();
+        follow = history[top] = index_.lower(value);
+        links = _links(follow);
+        --top;
+    }
+    // Go on till level 0, moving right while the next tower is smaller.
+    // The tower that stopped the walk on one level is often the next one
+    // on the level below too, it gets compared with value only once
+    for(int level = top; level >= 0; --level) {
+        while(links[level] && links[level] != stop) {
+            if(by_order) {
+                int order = _order(links[level], value, value_prefix, prefix_tag());
+                if(order >= 0) {
+                    stop = links[level];
+                    stop_order = order;
+                    break;
+                }
+            }
+            else if(!compare(links[level].key(), value)) {
+                stop = links[level];
+                break;
+            }
+            follow = links[level];
+            links = follow->next;
+        }
+        history[level] = follow;
+    }
+    SLNode<T, A, C, D> *found = key.empty() ? nullptr : links[0];
+    // found is the last tower that stopped the walk, if there is one.
+    // a three-way compare already told whether it is equal
+    if(equal)
+        *equal = found && (by_order ? stop_order == 0
+                                             : compare.equal_after_less(found->val, value));
+    return found;
 }
 
-template<typename T, typename X>
-// Inserting same will put it in a store and increment count
-// Insertion always starts at level 0
-void skiplist<T, X>::insert(T value) {
-    ++size_;
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+void skiplist<T, X, L, A, C, D>::set_finger(bool on) {
+    using finger_alloc_t = typename alloc_traits::template rebind_alloc<SLNode<T, A, C, D>*>;
+    using finger_traits = std::allocator_traits<finger_alloc_t>;
+    if(on == finger())
+        return;
+    finger_alloc_t alloc(get_allocator());
+    if(on) {
+        finger_ = finger_traits::allocate(alloc, L::max_level);
+        _finger_reset();
+    }
+    else {
+        finger_traits::deallocate(alloc, finger_, L::max_level);
+        finger_ = nullptr;
+    }
+}
 
-    // If entire container empty
-    if(key.empty()) {
-        SLNode<T> *node = new SLNode<T>(value);
-        SLNode<T> *keyd = new SLNode<T>();
-        key.push_back(keyd);
-        key[0]->next = node;
-        node->back = key[0];
-        last = node;
-        // Put the value into the store
-        node->valz.push_back(value);
-        // Now insert some more, probabilistically
-        while(this->dist_(this->mt_) > 0.5) {
-            node->up = new SLNode<T>(value);
-            node->up->down = node;
-            node = node->up;
-
-            keyd->up = new SLNode<T>();
-            keyd->up->down = keyd;
-            keyd = keyd->up;
-
-            keyd->next = node;
-            node->back = keyd;
-            key.push_back(keyd);
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+SLNode<T, A, C, D> *skiplist<T, X, L, A, C, D>::_finger_path(const T &value, SLNode<T, A, C, D> **history, bool *equal, bool either_way) {
+    const std::uint64_t value_prefix = _prefix(value, prefix_tag());
+    const int levels = (int)key.size();
+    // Once history on a level is less than value and the tower after it
+    // is not, history still holds there and on every level above it
+    int level = 0;
+    // history on the level below is not less than value
+    bool past = false;
+    while(level < levels) {
+        bool here = either_way && history[level] && !compare(history[level]->val, value);
+        if(!here) {
+            typename SLNode<T, A, C, D>::link next = _links(history[level])[level];
+            if(!next || !_before(next, value, value_prefix))
+                break;
         }
+        past = here;
+        ++level;
+    }
+    // Walk down from the highest level that moved, starting where it was,
+    // or from the tower above if that is past value
+    SLNode<T, A, C, D> *follow = !level ? nullptr
+                                : !past ? history[level - 1]
+                                : level < levels ? history[level] : nullptr;
+    typename SLNode<T, A, C, D>::link *links = _links(follow);
+    for(--level; level >= 0; --level) {
+        while(links[level] && _before(links[level], value, value_prefix)) {
+            follow = links[level];
+            links = follow->next;
+        }
+        history[level] = follow;
+    }
+    SLNode<T, A, C, D> *found = levels ? _links(history[0])[0] : nullptr;
+    *equal = found && compare.equal_after_less(found->val, value);
+    return found;
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+void skiplist<T, X, L, A, C, D>::_remove_node(SLNode<T, A, C, D> *node, SLNode<T, A, C, D> **history) {
+    if(history != finger_)
+        _finger_reset();
+    // The tower is the next node of its predecessor on every level it spans
+    for(int level = 0; level < node->height; ++level) {
+        _links(history[level])[level] = node->next[level];
+        if(!node->next[level])
+            tail[level] = history[level];
+    }
+    if(node->next[0])
+        node->next[0]->back = node->back;
+    else
+        last = node->back;
+    // Drop levels that became empty, so searches
+    // start from the highest level that has something in it
+    while(!key.empty() && !key.back()) {
+        key.pop_back();
+        tail.pop_back();
+    }
+    _index_remove(node);
+    SLNode<T, A, C, D>::destroy(pool_, node);
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+void skiplist<T, X, L, A, C, D>::_index_add(SLNode<T, A, C, D> *node) {
+    if(!index_.enabled)
+        return;
+    if(!index_.built()) {
+        if(size_ >= index_.min_size)
+            _index_build();
+        return;
+    }
+    index_.count(node->height, 1);
+    if(node->height > index_.level())
+        index_.insert(node->val, node);
+    // too many to search in one go, move up a level
+    if(index_.entries() > index_.max_entries)
+        _index_fill(index_.level() + 1);
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+void skiplist<T, X, L, A, C, D>::_index_remove(SLNode<T, A, C, D> *node) {
+    if(!index_.built())
+        return;
+    // not worth keeping around for a small list
+    if(size_ < index_.min_size / 4) {
+        index_.destroy(get_allocator());
         return;
     }
-    // Else
-    // Find the correct position, insert
-    // If not exists, create upper levels for that element
+    index_.count(node->height, -1);
+    if(node->height > index_.level())
+        index_.erase(node->val);
+    // the level below fits comfortably now, move down to it
+    if(index_.level() > 1 && index_.towers_at(index_.level() - 1) <= index_.max_entries / 2)
+        _index_fill(index_.level() - 1);
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+void skiplist<T, X, L, A, C, D>::_index_build() {
+    int hist[L::max_level];
+    _index_towers(hist);
+    _index_from(hist);
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+void skiplist<T, X, L, A, C, D>::_index_towers(int *hist) {
+    for(int i=0; i<L::max_level; i++)
+        hist[i] = 0;
+    if(index_.built()) {
+        for(int i=0; i<L::max_level; i++)
+            hist[i] = index_.towers_at(i) - (i + 1 < L::max_level ? index_.towers_at(i + 1) : 0);
+        return;
+    }
+    for(SLNode<T, A, C, D> *node = key.empty() ? nullptr : key[0]; node; node = node->next[0])
+        ++hist[node->height - 1];
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+void skiplist<T, X, L, A, C, D>::_index_from(const int *hist) {
+    index_.destroy(get_allocator());
+    index_.create(get_allocator());
+    for(int i=0; i<L::max_level; i++)
+        if(hist[i])
+            index_.count(i + 1, hist[i]);
+    int level = 1;
+    while(level + 1 < L::max_level && index_.towers_at(level) > index_.max_entries)
+        ++level;
+    _index_fill(level);
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+void skiplist<T, X, L, A, C, D>::_index_fill(int level) {
+    index_.reset(level);
+    if(level < (int)key.size())
+        for(SLNode<T, A, C, D> *node = key[level]; node; node = node->next[level])
+            index_.push_back(node->val, node);
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+// Inserting same will put it in a store and increment count
+// Insertion always starts at level 0
+template<typename U>
+void skiplist<T, X, L, A, C, D>::_insert(U &&value) {
+    ++size_;
 
     // This is the prev nodes for all levels
-    std::vector<SLNode<T>*> history;
-    // Search always starts from the upper left node
-    SLNode<T>* follow = key.back();
-    // Go on till level 0
-    while(follow->down) {
-        while(follow->next && compare(follow->next->val,value))
-            follow = follow->next;
-        history.push_back(follow);
-        follow = follow->down;
-    }
-    // Traverse at level 0 till dest reached
-    while(follow->next && compare(follow->next->val,value))
-        follow = follow->next;
+    // towers are never taller than max_level, so this fits on the stack.
+    // In finger mode it is the finger, which always has every level
+    SLNode<T, A, C, D> *path[L::max_level], **history = finger_ ? finger_ : path;
+    // Past the last element the tails are the path, so appending
+    // in order is O(1) expected
+    if(last && compare(last->val, value)) {
+        _link_node(SLNode<T, A, C, D>::create(pool_, _random_height(), std::forward<U>(value)), _tail_path(history));
+        return;
+    }
+    bool equal;
+    SLNode<T, A, C, D> *follow = finger_ ? _finger_path(value, history, &equal, true)
+                                         : _find_path(value, history, false, &equal);
 
     // If node already exists, add the new value to the store
-    if(follow->next && _420_is_equal(follow->next->val, value, compare)) {
-        follow = follow->next;
+    if(equal) {
+        follow->dups.push(std::forward<U>(value), get_allocator());
         follow->count++;
-        follow->valz.push_back(value);
         return;
     }
 
-    // Value does not exist. Insert a new node
-    SLNode<T> *node = new SLNode<T>(value), *keyd = key.back();
-    node->next = follow->next;
-    node->back = follow;
-    if(follow->next)
-        follow->next->back = node;
-    follow->next = node;
-    if(!node->next)
-        last = node;
-    // Add into storage
-    node->valz.push_back(value);
-
-    // Probabilistically add more levels
-    while(this->dist_(this->mt_) > 0.5) {
-        node->up = new SLNode<T>(value);
-        node->up->down = node;
-        node = node->up;
-        if(!history.empty()) {
-            node->next = history.back()->next;
-            node->back = history.back();
-            history.back()->next = node;
-            history.pop_back();
+    // Value does not exist. Insert a new tower, as tall as the coin says
+    int height = _random_height();
+    // the index skipped levels it needs
+    if(!finger_ && height > _quick_levels())
+        _find_path(value, history, true);
+    _link_node(SLNode<T, A, C, D>::create(pool_, height, std::forward<U>(value)), history);
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+template<typename... Args>
+typename skiplist<T, X, L, A, C, D>::iterator skiplist<T, X, L, A, C, D>::emplace(Args&&... args) {
+    // the element has to exist before it can be searched for,
+    // so it goes straight into a tower of its own
+    return _emplace_node(SLNode<T, A, C, D>::create(pool_, _random_height(), std::forward<Args>(args)...));
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+typename skiplist<T, X, L, A, C, D>::iterator skiplist<T, X, L, A, C, D>::_emplace_node(SLNode<T, A, C, D> *node) {
+    ++size_;
+
+    SLNode<T, A, C, D> *history[L::max_level];
+    if(last && compare(last->val, node->val)) {
+        _link_node(node, _tail_path(history));
+        return iterator(node);
+    }
+    bool equal;
+    SLNode<T, A, C, D> *follow = _find_path(node->val, history, false, &equal);
+
+    // an equal one is there already, the element moves next to it
+    // and the tower goes back to the pool
+    if(equal) {
+        follow->dups.push(std::move(node->val), get_allocator());
+        follow->count++;
+        SLNode<T, A, C, D>::destroy(pool_, node);
+        // the new element is the last of its node
+        return _newest(follow);
+    }
+
+    if(node->height > _quick_levels())
+        _find_path(node->val, history, true);
+    _link_node(node, history);
+    return iterator(node);
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+template<typename... Args>
+typename skiplist<T, X, L, A, C, D>::iterator skiplist<T, X, L, A, C, D>::emplace_hint(const_iterator hint, Args&&... args) {
+    SLNode<T, A, C, D> *node = SLNode<T, A, C, D>::create(pool_, _random_height(), std::forward<Args>(args)...);
+    SLNode<T, A, C, D> *equal;
+    if(!_at_hint(hint.node, node->val, equal))
+        return _emplace_node(node);
+    ++size_;
+    if(equal) {
+        equal->dups.push(std::move(node->val), get_allocator());
+        equal->count++;
+        SLNode<T, A, C, D>::destroy(pool_, node);
+        return _newest(equal);
+    }
+    _link_hint(hint.node, node);
+    return iterator(node);
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+template<typename U>
+typename skiplist<T, X, L, A, C, D>::iterator skiplist<T, X, L, A, C, D>::_insert_hint(const_iterator hint, U &&value) {
+    SLNode<T, A, C, D> *equal;
+    if(!_at_hint(hint.node, value, equal))
+        return emplace(std::forward<U>(value));
+    ++size_;
+    if(equal) {
+        equal->dups.push(std::forward<U>(value), get_allocator());
+        equal->count++;
+        return _newest(equal);
+    }
+    SLNode<T, A, C, D> *node = SLNode<T, A, C, D>::create(pool_, _random_height(), std::forward<U>(value));
+    _link_hint(hint.node, node);
+    return iterator(node);
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+bool skiplist<T, X, L, A, C, D>::_at_hint(SLNode<T, A, C, D> *next, const T &value, SLNode<T, A, C, D> *&equal) {
+    SLNode<T, A, C, D> *pred = next ? next->back : last;
+    if((pred && compare(value, pred->val)) || (next && compare(next->val, value)))
+        return false;
+    // neither is greater than value, so not less is equal
+    equal = pred && !compare(pred->val, value) ? pred
+          : next && !compare(value, next->val) ? next : nullptr;
+    return true;
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+bool skiplist<T, X, L, A, C, D>::_hint_path(SLNode<T, A, C, D> *next, int levels, SLNode<T, A, C, D> **history) {
+    if(!next) {
+        _tail_path(history);
+        return true;
+    }
+    // Most towers are short, and the one before next is tall enough
+    // for the first level at least. nullptr is the header, which is
+    // on every level
+    SLNode<T, A, C, D> *pred = next->back;
+    int level = 0;
+    for(int steps = 0; ; ++steps) {
+        while(level < levels && (!pred || pred->height > level))
+            history[level++] = pred;
+        if(level == levels)
+            return true;
+        if(steps == hint_steps)
+            return false;
+        pred = pred->back;
+    }
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+void skiplist<T, X, L, A, C, D>::_link_hint(SLNode<T, A, C, D> *next, SLNode<T, A, C, D> *node) {
+    SLNode<T, A, C, D> *history[L::max_level];
+    // levels the list does not have yet are filled in by _link_node
+    if(!_hint_path(next, std::min(node->height, (int)key.size()), history))
+        _find_path(node->val, history, true);
+    _link_node(node, history);
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+template<typename InputIterator>
+void skiplist<T, X, L, A, C, D>::insert_batch(InputIterator first, InputIterator last) {
+    using category = typename std::iterator_traits<InputIterator>::iterator_category;
+    if(std::is_base_of<std::forward_iterator_tag, category>::value && std::is_sorted(first, last, compare)) {
+        _insert_sorted(first, last);
+        return;
+    }
+    // stable, so equal elements go in in the order they came
+    std::vector<T, node_alloc_t> batch(first, last, node_alloc_t(get_allocator()));
+    std::stable_sort(batch.begin(), batch.end(), compare);
+    _insert_sorted(std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end()));
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+template<typename InputIterator>
+void skiplist<T, X, L, A, C, D>::erase_batch(InputIterator first, InputIterator last) {
+    using category = typename std::iterator_traits<InputIterator>::iterator_category;
+    if(std::is_base_of<std::forward_iterator_tag, category>::value && std::is_sorted(first, last, compare)) {
+        _erase_sorted(first, last);
+        return;
+    }
+    std::vector<T, node_alloc_t> batch(first, last, node_alloc_t(get_allocator()));
+    std::sort(batch.begin(), batch.end(), compare);
+    _erase_sorted(batch.begin(), batch.end());
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+template<typename InputIterator>
+void skiplist<T, X, L, A, C, D>::_insert_sorted(InputIterator first, InputIterator end) {
+    // the path of the element before, nothing comes before the first one
+    SLNode<T, A, C, D> *history[L::max_level];
+    for(int level = 0; level < (int)key.size(); ++level)
+        history[level] = nullptr;
+    for(; first != end; ++first) {
+        ++size_;
+        bool equal;
+        SLNode<T, A, C, D> *follow = _finger_path(*first, history, &equal);
+        if(equal) {
+            follow->dups.push(*first, get_allocator());
+            follow->count++;
+            continue;
         }
-        else {
-            // add directly to the key
-            // mess around with the pointers
-            keyd->up = new SLNode<T>();
-            keyd->up->down = keyd;
-            keyd = keyd->up;
-
-            keyd->next = node;
-            node->back = keyd;
-            key.push_back(keyd);
+        // history stays right for the next element: the new tower is
+        // not less than anything that comes after it
+        _link_node(SLNode<T, A, C, D>::create(pool_, _random_height(), *first), history);
+    }
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+template<typename InputIterator>
+void skiplist<T, X, L, A, C, D>::_erase_sorted(InputIterator first, InputIterator end) {
+    SLNode<T, A, C, D> *history[L::max_level];
+    for(int level = 0; level < (int)key.size(); ++level)
+        history[level] = nullptr;
+    for(; first != end && !key.empty(); ++first) {
+        bool equal;
+        SLNode<T, A, C, D> *follow = _finger_path(*first, history, &equal);
+        if(!equal)
+            continue;
+        follow->count--;
+        --size_;
+        if(follow->count) {
+            follow->dups.pop();
+            continue;
+        }
+        // levels the tower leaves empty are dropped, history
+        // below that is still right for the next element
+        _remove_node(follow, history);
+    }
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+template<typename InputIterator>
+void skiplist<T, X, L, A, C, D>::_build_sorted(InputIterator first, InputIterator end, bool ideal) {
+    // every new tower goes at the end of all the levels it spans
+    std::size_t towers = 0;
+    for(; first != end; ++first) {
+        ++size_;
+        // a run of equal elements shares the tower of the first one.
+        // the input is sorted, so the last one is not greater
+        if(last && compare.equal_after_less(*first, last->val)) {
+            last->dups.push(*first, get_allocator());
+            last->count++;
+            continue;
+        }
+        int height = ideal ? L::ideal_height(++towers) : _random_height();
+        SLNode<T, A, C, D> *node = SLNode<T, A, C, D>::create(pool_, height, *first);
+        while((int)key.size() < height) {
+            tail.push_back(nullptr);
+            key.push_back(nullptr);
         }
+        for(int level = 0; level < height; ++level) {
+            _links(tail[level])[level] = node;
+            tail[level] = node;
+        }
+        node->back = last;
+        last = node;
+    }
+    // the index is made in one go too, once everything is in
+    if(index_.enabled && !index_.built() && size_ >= index_.min_size)
+        _index_build();
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+template<typename InputIterator>
+void skiplist<T, X, L, A, C, D>::_build(InputIterator first, InputIterator end, std::input_iterator_tag) {
+    for(; first != end; ++first)
+        insert(*first);
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+template<typename ForwardIterator>
+void skiplist<T, X, L, A, C, D>::_build(ForwardIterator first, ForwardIterator end, std::forward_iterator_tag) {
+    if(std::is_sorted(first, end, compare)) {
+        _build_sorted(first, end, false);
+        return;
+    }
+    for(; first != end; ++first)
+        insert(*first);
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+void skiplist<T, X, L, A, C, D>::_link_node(SLNode<T, A, C, D> *node, SLNode<T, A, C, D> **history) {
+    if(history != finger_)
+        _finger_reset();
+    // A tower taller than the list adds levels to the key.
+    // towers are capped by size, so this only happens O(log n) times
+    while((int)key.size() < node->height) {
+        history[key.size()] = nullptr;
+        key.push_back(nullptr);
+        tail.push_back(nullptr);
+    }
+    for(int level = 0; level < node->height; ++level) {
+        typename SLNode<T, A, C, D>::link *links = _links(history[level]);
+        node->next[level] = links[level];
+        links[level] = node;
+        if(!node->next[level])
+            tail[level] = node;
     }
+    node->back = history[0];
+    if(node->next[0])
+        node->next[0]->back = node;
+    else
+        last = node;
+    _index_add(node);
 }
 
-template<typename T, typename X>
+template<typename T, typename X, typename L, typename A, bool C, typename D>
 // Cannot assume element exists
-void skiplist<T, X>::erase(T value) {
+void skiplist<T, X, L, A, C, D>::erase(const T &value) {
     if(key.empty())
         return;
     // Find value
     // Decrement its counter
     // If counter is zero, remove it
     // If value does not exist, exit
-
-    // Start from top left
-    SLNode<T>* follow = key.back();
-    // Go on till level 0
-    while(follow->down) {
-        while(follow->next && compare(follow->next->val, value))
-            follow = follow->next;
-        follow = follow->down;
-    }
-    // Traverse at level 0 till dest reached
-    while(follow->next && compare(follow->next->val, value))
-        follow = follow->next;
+    SLNode<T, A, C, D> *path[L::max_level], **history = finger_ ? finger_ : path;
+    bool equal;
+    SLNode<T, A, C, D> *follow = finger_ ? _finger_path(value, history, &equal, true)
+                                         : _find_path(value, history, false, &equal);
 
     // If not exist, leave
-    if(!follow->next || !_420_is_equal(follow->next->val, value, compare))
+    if(!equal)
         return;
 
     // This is the node for sure
-    follow = follow->next;
-    follow->valz.pop_back();
     follow->count--;
     --size_;
 
-    if(follow->count)
+    if(follow->count) {
+        follow->dups.pop();
         return;
+    }
     // Remove it if count is zero
-    last = follow->back;
-    SLNode<T> *tmp;
-    // Go up all levels of that node and delete them
-    while(follow) {
-        follow->back->next = follow->next;
-        if(follow->next)
-            follow->next->back = follow->back;
-        tmp = follow->up;
-        delete follow;
-        follow = tmp;
-    }
-    // TODO : We have decided to leave the key structure unaltered
-    // This means even if a level is empty, it is still preserved.
-    // Need to discuss the benefits / costs of doing that
-
-    // I don't think leaving it unaltered makes the implmentation incorrect...
-    // but please check that once if you come across unexpected behaviour later on
-}
-
-template<typename T, typename X>
+    if(!finger_ && follow->height > _quick_levels())
+        _find_path(value, history, true);
+    _remove_node(follow, history);
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
 // Assume that iterator is valid
 // After erasing, move on to the next element
-typename skiplist<T, X>::iterator skiplist<T, X>::erase(typename skiplist<T, X>::iterator it) {
-    SLNode<T> *follow = it.node;
+typename skiplist<T, X, L, A, C, D>::iterator skiplist<T, X, L, A, C, D>::erase(typename skiplist<T, X, L, A, C, D>::iterator it) {
+    SLNode<T, A, C, D> *follow = it.node;
     // This is the node for sure
     follow->count--;
-    follow->valz.pop_back();
     --size_;
 
-    if(follow->count)
+    if(follow->count) {
+        follow->dups.pop();
         return it;
+    }
 
     // Remove it if count is zero
-    last = follow->back;
-    SLNode<T> *tmp, *ret(follow->next);
-    // Go up all levels of that node and delete them
-    while(follow) {
-        follow->back->next = follow->next;
-        if(follow->next)
-            follow->next->back = follow->back;
-        tmp = follow->up;
-        delete follow;
-        follow = tmp;
-    }
+    // Towers only know what comes after them, so look up the predecessors
+    SLNode<T, A, C, D> *history[L::max_level];
+    _find_path(follow->val, history, follow->height > _quick_levels());
+    SLNode<T, A, C, D> *ret(follow->next[0]);
+    _remove_node(follow, history);
     return iterator(ret);
-    // NOTE: If there are bugs in this function due to layer management
-    // check the erase function above for explanantion and fixes
 }
 
-template<typename T, typename X>
-typename skiplist<T, X>::iterator skiplist<T, X>::find(T value) {
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+template<typename K>
+typename skiplist<T, X, L, A, C, D>::iterator skiplist<T, X, L, A, C, D>::_find(const K &value) {
     // Same algorithm as erase, but without erasing anything ;)
     if(key.empty())
         return end();
 
-    // Start from top left
-    SLNode<T>* follow = key.back();
-    // Go on till level 0
-    while(follow->down) {
-        while(follow->next && compare(follow->next->val, value))
-            follow = follow->next;
-        follow = follow->down;
+    // Start from top left, or from the index
+    SLNode<T, A, C, D> *follow = nullptr;
+    typename SLNode<T, A, C, D>::link *links = key.data();
+    int top = (int)key.size() - 1;
+    if(_quick_levels() <= top) {
+        follow = index_.lower(value);
+        links = _links(follow);
+        top = index_.level() - 1;
+    }
+    // prefixes only help searching for a val_type
+    using tag = std::integral_constant<bool, prefixed_ && std::is_same<K, T>::value>;
+    const bool by_order = tag::value || compare.three_way;
+    const std::uint64_t value_prefix = _prefix(value, tag());
+    // Go on till level 0, dropping a level inside the same tower.
+    // A tower that stopped the walk is not compared again a level down
+    SLNode<T, A, C, D> *stop = nullptr;
+    for(int level = top; level >= 0; --level) {
+        while(links[level] && links[level] != stop) {
+            if(by_order) {
+                int order = _order(links[level], value, value_prefix, tag());
+                // there is one tower per element, so this is it
+                if(order == 0)
+                    return iterator(links[level]);
+                if(order > 0) {
+                    stop = links[level];
+                    break;
+                }
+            }
+            else if(!compare(links[level].key(), value)) {
+                stop = links[level];
+                break;
+            }
+            follow = links[level];
+            links = follow->next;
+        }
     }
-    // Traverse at level 0 till dest reached
-    while(follow->next && compare(follow->next->val, value))
-        follow = follow->next;
+    // a three-way compare would have seen an equal tower on the way
+    if(by_order)
+        return end();
+    follow = links[0];
 
     // If not exist, leave
-    if(!follow->next || !_420_is_equal(follow->next->val, value, compare))
+    if(!follow || !compare.equal_after_less(follow->val, value))
         return end();
 
     // This is the node for sure
-    follow = follow->next;
     return iterator(follow);
 }
 
-template<typename T, typename X>
-std::ostream &operator<<(std::ostream &out, const skiplist<T, X>& sl) {
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+template<typename K>
+SLNode<T, A, C, D> *skiplist<T, X, L, A, C, D>::_bound(const K &value, bool upper) {
+    if(key.empty())
+        return nullptr;
+    // Start from top left, or from the index. The index stops before
+    // towers equal to value, which is fine for either bound
+    SLNode<T, A, C, D> *follow = nullptr;
+    typename SLNode<T, A, C, D>::link *links = key.data();
+    int top = (int)key.size() - 1;
+    if(_quick_levels() <= top) {
+        follow = index_.lower(value);
+        links = _links(follow);
+        top = index_.level() - 1;
+    }
+    using tag = std::integral_constant<bool, prefixed_ && std::is_same<K, T>::value>;
+    const bool by_order = tag::value || compare.three_way;
+    const std::uint64_t value_prefix = _prefix(value, tag());
+    // Same walk as _find, moving right past towers less than value,
+    // or for upper, not greater than it
+    SLNode<T, A, C, D> *stop = nullptr;
+    for(int level = top; level >= 0; --level) {
+        while(links[level] && links[level] != stop) {
+            bool before;
+            if(by_order) {
+                int order = _order(links[level], value, value_prefix, tag());
+                before = upper ? order <= 0 : order < 0;
+            }
+            else
+                before = upper ? !compare(value, links[level].key()) : compare(links[level].key(), value);
+            if(!before) {
+                stop = links[level];
+                break;
+            }
+            follow = links[level];
+            links = follow->next;
+        }
+    }
+    return links[0];
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+template<typename K>
+std::pair<typename skiplist<T, X, L, A, C, D>::iterator, typename skiplist<T, X, L, A, C, D>::iterator>
+skiplist<T, X, L, A, C, D>::_equal_range(const K &value) {
+    SLNode<T, A, C, D> *first = _bound(value, false), *last = first;
+    // one tower per element for val_type, a transparent compare may
+    // find a few more equal to value
+    while(last && !compare(value, last->val))
+        last = last->next[0];
+    return std::make_pair(iterator(first), iterator(last));
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+typename skiplist<T, X, L, A, C, D>::iterator skiplist<T, X, L, A, C, D>::erase(const_iterator first, const_iterator last) {
+    SLNode<T, A, C, D> *head = first.node, *stop = last.node;
+    const int from = first._index(), to = last._index();
+    // Both ends in one tower, only copies go
+    if(head == stop) {
+        if(head && to > from)
+            _drop_copies(head, from, to);
+        iterator it(head);
+        for(int i=0; i<from; i++)
+            ++it;
+        return it;
+    }
+    // A tower the range only covers part of keeps the copies outside it
+    if(from) {
+        _drop_copies(head, from, head->count);
+        head = head->next[0];
+    }
+    if(to)
+        _drop_copies(stop, 0, to);
+    if(head != stop)
+        _unlink_span(head, stop);
+    return iterator(stop);
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+void skiplist<T, X, L, A, C, D>::_unlink_span(SLNode<T, A, C, D> *first, SLNode<T, A, C, D> *stop) {
+    // The predecessors of first and of stop on every level. Where they
+    // differ, the towers in between are on that level, and the
+    // predecessor of first gets linked straight to what comes after them
+    SLNode<T, A, C, D> *before[L::max_level], *after[L::max_level];
+    _find_path(first->val, before, true);
+    if(stop)
+        _find_path(stop->val, after, true);
+    else
+        _tail_path(after);
+    // The towers of the span tall enough to be in the index sit next to
+    // each other in it too, and come out of it in one go
+    const int index_level = index_.built() ? index_.level() : L::max_level;
+    if(index_level < (int)key.size() && before[index_level] != after[index_level]) {
+        SLNode<T, A, C, D> *from = _links(before[index_level])[index_level], *node = from;
+        std::size_t indexed = 1;
+        for(; node != after[index_level]; node = node->next[index_level])
+            ++indexed;
+        index_.erase(from->val, indexed);
+    }
+    for(int level = 0; level < (int)key.size(); ++level) {
+        if(before[level] == after[level])
+            continue;
+        typename SLNode<T, A, C, D>::link next = after[level]->next[level];
+        _links(before[level])[level] = next;
+        if(!next)
+            tail[level] = before[level];
+    }
+    if(stop)
+        stop->back = before[0];
+    else
+        last = before[0];
+    while(!key.empty() && !key.back()) {
+        key.pop_back();
+        tail.pop_back();
+    }
+    _finger_reset();
+    // Level 0 of the span is still linked up, free it in one sweep
+    while(first != stop) {
+        SLNode<T, A, C, D> *next = first->next[0];
+        size_ -= first->count;
+        if(index_.built())
+            index_.count(first->height, -1);
+        SLNode<T, A, C, D>::destroy(pool_, first);
+        first = next;
+    }
+    // like _index_remove, but once for the whole span
+    if(index_.built()) {
+        if(size_ < index_.min_size / 4) {
+            index_.destroy(get_allocator());
+            return;
+        }
+        int level = index_.level();
+        while(level > 1 && index_.towers_at(level - 1) <= index_.max_entries / 2)
+            --level;
+        if(level != index_.level())
+            _index_fill(level);
+    }
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+skiplist<T, X, L, A, C, D> skiplist<T, X, L, A, C, D>::split(const T &value) {
+    skiplist right(get_allocator());
+    right.set_finger(finger());
+    if(key.empty())
+        return right;
+    SLNode<T, A, C, D> *history[L::max_level];
+    SLNode<T, A, C, D> *first = _find_path(value, history, true);
+    if(!first)
+        return right;
+    _finger_reset();
+
+    // The sizes, and for the index the towers of every height, of the
+    // smaller half: walk both halves away from the cut in step till one
+    // runs out. The other half has the rest
+    int left_hist[L::max_level] = {}, right_hist[L::max_level] = {};
+    int left_size = 0, right_size = 0;
+    SLNode<T, A, C, D> *l = history[0], *r = first;
+    for(; l && r; l = l->back, r = r->next[0]) {
+        left_size += l->count;
+        ++left_hist[l->height - 1];
+        right_size += r->count;
+        ++right_hist[r->height - 1];
+    }
+    if(r)
+        right_size = size_ - left_size;
+    else
+        left_size = size_ - right_size;
+    const bool indexed = index_.built();
+    if(indexed) {
+        int total[L::max_level];
+        _index_towers(total);
+        int *rest = r ? right_hist : left_hist, *known = r ? left_hist : right_hist;
+        for(int i=0; i<L::max_level; i++)
+            rest[i] = total[i] - known[i];
+    }
+
+    // Cut every level after the path. What came after it starts the
+    // levels of the right half, and the path is the new tails here
+    const int levels = (int)key.size();
+    right.key.assign(levels, nullptr);
+    right.tail.assign(levels, nullptr);
+    for(int level = 0; level < levels; ++level) {
+        typename SLNode<T, A, C, D>::link *links = _links(history[level]);
+        if(links[level]) {
+            right.key[level] = links[level];
+            right.tail[level] = tail[level];
+            links[level] = nullptr;
+        }
+        tail[level] = history[level];
+    }
+    while(!key.empty() && !key.back()) {
+        key.pop_back();
+        tail.pop_back();
+    }
+    while(!right.key.empty() && !right.key.back()) {
+        right.key.pop_back();
+        right.tail.pop_back();
+    }
+    first->back = nullptr;
+    right.last = last;
+    last = history[0];
+    right.size_ = right_size;
+    size_ = left_size;
+    // both halves have towers in our slabs now
+    pool_.share(right.pool_);
+
+    if(indexed) {
+        if(size_ < index_.min_size / 4)
+            index_.destroy(get_allocator());
+        else
+            _index_from(left_hist);
+        if(right.size_ >= index_.min_size / 4)
+            right._index_from(right_hist);
+    }
+    return right;
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+void skiplist<T, X, L, A, C, D>::join(skiplist &other) {
+    if(this == &other || other.key.empty())
+        return;
+    if(!pool_.compatible(other.pool_)) {
+        merge(other);
+        return;
+    }
+    if(!key.empty() && !compare(last->val, other.key[0]->val)) {
+        if(!compare(other.last->val, key[0]->val)) {
+            merge(other);
+            return;
+        }
+        // other comes first. Its levels go in front of ours, which is
+        // ours linked after its
+        _swap_levels(other);
+    }
+    _append(other);
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+void skiplist<T, X, L, A, C, D>::_append(skiplist &other) {
+    // The index covers both, counted while they are still apart
+    int hist[L::max_level];
+    const bool indexed = index_.enabled
+        && (index_.built() || other.index_.built() || size_ + other.size_ >= index_.min_size);
+    if(indexed) {
+        int theirs[L::max_level];
+        _index_towers(hist);
+        other._index_towers(theirs);
+        for(int i=0; i<L::max_level; i++)
+            hist[i] += theirs[i];
+    }
+    other.index_.destroy(other.get_allocator());
+    pool_.adopt(other.pool_);
+    _finger_reset();
+    other._finger_reset();
+
+    // The first tower of other on every level follows our tail there
+    for(int level = 0; level < (int)other.key.size(); ++level) {
+        if(level < (int)key.size())
+            tail[level]->next[level] = other.key[level];
+        else {
+            key.push_back(other.key[level]);
+            tail.push_back(nullptr);
+        }
+        tail[level] = other.tail[level];
+    }
+    SLNode<T, A, C, D> *first = other.key[0];
+    first->back = last;
+    last = other.last;
+    size_ += other.size_;
+
+    other.key.clear();
+    other.tail.clear();
+    other.last = nullptr;
+    other.size_ = 0;
+    if(indexed)
+        _index_from(hist);
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+void skiplist<T, X, L, A, C, D>::merge(skiplist &other) {
+    if(this == &other || other.key.empty())
+        return;
+    // towers can only change hands if our pool can free them
+    if(!pool_.compatible(other.pool_)) {
+        insert_batch(other.begin(), other.end());
+        other.destroy_all_levels();
+        other.size_ = 0;
+        return;
+    }
+    if(key.empty() || compare(last->val, other.key[0]->val) || compare(other.last->val, key[0]->val)) {
+        join(other);
+        return;
+    }
+    pool_.adopt(other.pool_);
+    SLNode<T, A, C, D> *node = other.key[0];
+    other.index_.destroy(other.get_allocator());
+    other.key.clear();
+    other.tail.clear();
+    other.last = nullptr;
+    other.size_ = 0;
+    other._finger_reset();
+
+    // Same as _insert_sorted, with towers that are already made.
+    // Their next links are only read before they get relinked
+    SLNode<T, A, C, D> *history[L::max_level];
+    for(int level = 0; level < (int)key.size(); ++level)
+        history[level] = nullptr;
+    while(node) {
+        SLNode<T, A, C, D> *next = node->next[0];
+        size_ += node->count;
+        bool equal;
+        SLNode<T, A, C, D> *follow = _finger_path(node->val, history, &equal);
+        if(equal) {
+            follow->dups.take(std::move(node->val), node->dups, get_allocator());
+            follow->count += node->count;
+            SLNode<T, A, C, D>::destroy(pool_, node);
+        }
+        else
+            _link_node(node, history);
+        node = next;
+    }
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+template<typename ForwardIterator, typename OutputIterator>
+OutputIterator skiplist<T, X, L, A, C, D>::find_batch(ForwardIterator first, ForwardIterator last, OutputIterator out) {
+    _find_batch(first, last, [&out](SLNode<T, A, C, D> *found) { *out++ = iterator(found); });
+    return out;
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+template<typename ForwardIterator, typename OutputIterator>
+OutputIterator skiplist<T, X, L, A, C, D>::count_batch(ForwardIterator first, ForwardIterator last, OutputIterator out) {
+    _find_batch(first, last, [&out](SLNode<T, A, C, D> *found) { *out++ = found ? found->count : 0; });
+    return out;
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+template<typename ForwardIterator, typename Emit>
+void skiplist<T, X, L, A, C, D>::_find_batch(ForwardIterator first, ForwardIterator last, Emit emit) {
+    const int top = (int)key.size() - 1;
+    const bool indexed = _quick_levels() <= top;
+    ForwardIterator values[batch_width];
+    batch_lookup_t lookups[batch_width];
+    while(first != last) {
+        // Start the next lot from top left, or from the index
+        int width = 0;
+        for(; width < batch_width && first != last; ++first, ++width) {
+            batch_lookup_t &lookup = lookups[width];
+            values[width] = first;
+            lookup.links = key.data();
+            lookup.stop = nullptr;
+            lookup.prefix = _prefix(*first, prefix_tag());
+            lookup.level = top;
+            lookup.ready = false;
+            if(indexed) {
+                lookup.links = _links(index_.lower(*first));
+                lookup.level = index_.level() - 1;
+            }
+        }
+        // Round and round till every one of them is on level 0
+        for(bool going = true; going; ) {
+            going = false;
+            for(int i=0; i<width; i++)
+                if(lookups[i].level >= 0)
+                    going |= _batch_step(lookups[i], *values[i]);
+        }
+        for(int i=0; i<width; i++) {
+            SLNode<T, A, C, D> *found = top >= 0 ? lookups[i].links[0] : nullptr;
+            emit(found && compare.equal_after_less(found->val, *values[i]) ? found : nullptr);
+        }
+    }
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+bool skiplist<T, X, L, A, C, D>::_batch_step(batch_lookup_t &lookup, const T &value) {
+    // Same walk as _find_path, dropping levels inside the same tower
+    // costs nothing, moving to another tower costs a load
+    for(;;) {
+        link_t next = lookup.links[lookup.level];
+        if(next && next != lookup.stop) {
+            // without a key in the link the compare loads the tower itself
+            if(!C && !lookup.ready) {
+                _sl_prefetch(&next->val);
+                lookup.ready = true;
+                return true;
+            }
+            lookup.ready = false;
+            if(_before(next, value, lookup.prefix)) {
+                lookup.links = next->next;
+                _sl_prefetch(lookup.links + lookup.level);
+                return true;
+            }
+            lookup.stop = next;
+        }
+        if(--lookup.level < 0)
+            return false;
+    }
+}
+
+template<typename T, typename X, typename L, typename A, bool C, typename D>
+std::ostream &operator<<(std::ostream &out, const skiplist<T, X, L, A, C, D>& sl) {
     if (sl.key.empty()) {
         return out << "EMPTY SKIPLIST" << std::endl;
     }
 
     // store mapping of node->index in a map
     std::map<T, int> index_store{};
-    auto bottom_it = (*(sl.key.begin()))->next;
+    auto bottom_it = sl.key[0];
     int cur_index = 0;
     while (bottom_it) {
         index_store[bottom_it->val] = cur_index;
         cur_index++;
-        bottom_it = bottom_it->next;
+        bottom_it = bottom_it->next[0];
     }
 
-    auto level = sl.key.rbegin();
-    auto end = sl.key.rend();
-    while(level != end) {
+    for (int level = (int)sl.key.size() - 1; level >= 0; --level) {
         // S denotes start of level, could be something different
         out << "S";
 
         // to store previous element's index
         // and current element's index
         int index = -1, next_index;
-        // skip the first element - it is always 0
-        auto it = (*level)->next;
+        auto it = sl.key[level];
         // iterate through the list at this level
         while (it) {
             next_index = index_store[it->val];
@@ -656,7 +2047,7 @@ std::ostream &operator<<(std::ostream &out, const skiplist<T, X>& sl) {
             // width of printed element is hardcoded to 3 for now
             // the padding is filled with ""-"
             out << "-" << std::setfill('-') << std::setw(3) << it->val;
-            it = it->next;
+            it = it->next[level];
 
             index = next_index;
         }
@@ -669,13 +2060,27 @@ std::ostream &operator<<(std::ostream &out, const skiplist<T, X>& sl) {
         out << "-E";
 
         out << std::endl;
-
-        level++;
     }
 
     return out;
 }
 // End of cpp file
 
+// skiplist on a std::pmr::memory_resource, C++17 onwards
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+namespace pmr {
+template<
+    typename val_type,
+    typename compare_t = std::less<val_type>,
+    typename level_t = SLHalfLevels<>
+>
+using skiplist = ::skiplist<val_type, compare_t, level_t,
+                            std::pmr::polymorphic_allocator<val_type> >;
+}
+#endif
+#endif
+
 #endif
 // End of header file
@@ -0,0 +1,74 @@
+/*
+Comparator adapter for the skiplist containers
+Lets a container search with either a less-than or a three-way comparator
+*/
+#ifndef SKIPLIST_COMPARE_H
+#define SKIPLIST_COMPARE_H
+#include <type_traits>
+#if __cplusplus > 201703L
+#include <compare>
+#endif
+
+template<typename...>
+struct _sl_void { using type = void; };
+
+// Is Compare a three-way comparator? Those return something that compares
+// against 0 like a.compare(b) does: below 0 for less, 0 for equal and
+// above 0 for greater, so a single call tells all three apart.
+// A comparator says so with an is_three_way member type.
+// std::compare_three_way (C++20) is one too.
+template<typename Compare, typename = void>
+struct SLThreeWay : std::false_type {};
+
+template<typename Compare>
+struct SLThreeWay<Compare, typename _sl_void<typename Compare::is_three_way>::type>
+: std::true_type {};
+
+#if defined(__cpp_lib_three_way_comparison)
+template<>
+struct SLThreeWay<std::compare_three_way> : std::true_type {};
+#endif
+
+// What the containers hold instead of the comparator itself.
+// Called like the comparator was a less-than, whatever it really is.
+// order() is -1, 0 or 1 for a less than, equal to or greater than b,
+// which costs a three-way comparator one call and a less-than two.
+// equal() after a search that found !(a < b) only needs b < a, see
+// equal_after_less
+template<typename Compare, bool ThreeWay = SLThreeWay<Compare>::value>
+struct SLCompare {
+    static const bool three_way = false;
+    Compare comp;
+
+    template<typename A, typename B>
+    bool operator()(const A &a, const B &b) const { return comp(a, b); }
+    template<typename A, typename B>
+    int order(const A &a, const B &b) const {
+        return comp(a, b) ? -1 : comp(b, a) ? 1 : 0;
+    }
+    template<typename A, typename B>
+    bool equal(const A &a, const B &b) const { return !comp(a, b) && !comp(b, a); }
+    // a is known not to be less than b
+    template<typename A, typename B>
+    bool equal_after_less(const A &a, const B &b) const { return !comp(b, a); }
+};
+
+template<typename Compare>
+struct SLCompare<Compare, true> {
+    static const bool three_way = true;
+    Compare comp;
+
+    template<typename A, typename B>
+    bool operator()(const A &a, const B &b) const { return comp(a, b) < 0; }
+    template<typename A, typename B>
+    int order(const A &a, const B &b) const {
+        auto c = comp(a, b);
+        return c < 0 ? -1 : c == 0 ? 0 : 1;
+    }
+    template<typename A, typename B>
+    bool equal(const A &a, const B &b) const { return comp(a, b) == 0; }
+    template<typename A, typename B>
+    bool equal_after_less(const A &a, const B &b) const { return comp(a, b) == 0; }
+};
+
+#endif
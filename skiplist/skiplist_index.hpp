@@ -0,0 +1,183 @@
+/*
+Dense index over one of the top levels of a skiplist
+Lets a search skip the sparse upper levels with a look through an array
+*/
+#ifndef SKIPLIST_INDEX_H
+#define SKIPLIST_INDEX_H
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Should a skiplist keep a dense index of its top levels?
+// On for arithmetic keys in their usual order, which the index can search
+// without calling the comparator. Specialize to change that
+template<typename T, typename Compare>
+struct SLDenseIndex {
+    static const bool value = std::is_arithmetic<T>::value
+        && std::is_same<Compare, std::less<T> >::value;
+};
+
+// Sorted keys of every tower at one level, side by side with the towers.
+// Searching it lands on the last tower before a key at that level, which
+// is where walking down from the header through all the levels above
+// would have got to, one dependent load per step.
+// The keys are packed and there are at most about max_entries of them,
+// so the array stays in L1 and the search has no branch to mispredict.
+// The level is the lowest one with at most max_entries towers, picked
+// from a count of towers per level kept up to date as towers come and go.
+// Nothing is allocated till the list has min_size elements, and the
+// list frees it again once it gets well below that.
+template<typename Node, typename K, typename Alloc, int MaxLevel, bool Enabled>
+class SLTopIndex {
+private:
+    using alloc_traits = std::allocator_traits<Alloc>;
+    using key_alloc_t = typename alloc_traits::template rebind_alloc<K>;
+    using tower_alloc_t = typename alloc_traits::template rebind_alloc<Node*>;
+
+    struct Table {
+        // level the keys come from
+        int level;
+        // towers per level, which is every tower at least that tall
+        int counts[MaxLevel];
+        std::vector<K, key_alloc_t> keys;
+        std::vector<Node*, tower_alloc_t> towers;
+
+        explicit Table(const Alloc &alloc)
+        : level(0), keys(key_alloc_t(alloc)), towers(tower_alloc_t(alloc)) {
+            for(int i=0; i<MaxLevel; i++)
+                counts[i] = 0;
+        }
+    };
+    using table_alloc_t = typename alloc_traits::template rebind_alloc<Table>;
+    using table_traits = std::allocator_traits<table_alloc_t>;
+
+    Table *tab_;
+
+    // number of keys less than value. Both sides of every comparison
+    // are loads from the same few cache lines, so this compiles to
+    // conditional moves rather than branches
+    template<typename Q>
+    std::size_t _lower(const Q &value) const {
+        std::size_t n = tab_->keys.size();
+        if(!n)
+            return 0;
+        const K *first = tab_->keys.data(), *base = first;
+        while(n > 1) {
+            std::size_t half = n / 2;
+            base = base[half] < value ? base + half : base;
+            n -= half;
+        }
+        return (base - first) + (*base < value);
+    }
+
+public:
+    static const bool enabled = true;
+    // most towers worth indexing, about 12KB of keys and pointers for ints
+    static const int max_entries = 1024;
+    // lists smaller than this go without
+    static const int min_size = 1024;
+
+    SLTopIndex() : tab_(nullptr) {}
+    SLTopIndex(const SLTopIndex &) = delete;
+    SLTopIndex &operator=(const SLTopIndex &) = delete;
+    SLTopIndex(SLTopIndex &&other) : tab_(other.tab_) { other.tab_ = nullptr; }
+    // the table must have been destroyed by now
+    SLTopIndex &operator=(SLTopIndex &&other) {
+        tab_ = other.tab_;
+        other.tab_ = nullptr;
+        return *this;
+    }
+
+    // the memory comes from the list's allocator, which is handed in
+    // rather than kept, so the index stays a single pointer
+    void create(const Alloc &alloc) {
+        table_alloc_t table_alloc(alloc);
+        Table *tab = table_traits::allocate(table_alloc, 1);
+        table_traits::construct(table_alloc, tab, alloc);
+        tab_ = tab;
+    }
+    void destroy(const Alloc &alloc) {
+        if(!tab_)
+            return;
+        table_alloc_t table_alloc(alloc);
+        table_traits::destroy(table_alloc, tab_);
+        table_traits::deallocate(table_alloc, tab_, 1);
+        tab_ = nullptr;
+    }
+
+    bool built() const { return tab_ != nullptr; }
+    int level() const { return tab_->level; }
+    int entries() const { return (int)tab_->keys.size(); }
+    int towers_at(int level) const { return tab_->counts[level]; }
+
+    // a tower of height levels came (delta 1) or went (delta -1)
+    void count(int height, int delta) {
+        for(int i=0; i<height; i++)
+            tab_->counts[i] += delta;
+    }
+
+    // start over at another level, its towers get pushed in order
+    void reset(int level) {
+        tab_->level = level;
+        tab_->keys.clear();
+        tab_->towers.clear();
+    }
+    void push_back(const K &k, Node *node) {
+        tab_->keys.push_back(k);
+        tab_->towers.push_back(node);
+    }
+
+    void insert(const K &k, Node *node) {
+        std::size_t pos = _lower(k);
+        tab_->keys.insert(tab_->keys.begin() + pos, k);
+        tab_->towers.insert(tab_->towers.begin() + pos, node);
+    }
+    // keys are unique, equal elements share a tower
+    void erase(const K &k) {
+        std::size_t pos = _lower(k);
+        tab_->keys.erase(tab_->keys.begin() + pos);
+        tab_->towers.erase(tab_->towers.begin() + pos);
+    }
+    // n keys in a row, from k on
+    void erase(const K &k, std::size_t n) {
+        std::size_t pos = _lower(k);
+        tab_->keys.erase(tab_->keys.begin() + pos, tab_->keys.begin() + pos + n);
+        tab_->towers.erase(tab_->towers.begin() + pos, tab_->towers.begin() + pos + n);
+    }
+
+    // last tower at level() with a key less than value, nullptr for the header.
+    // value can be anything that compares against K with <
+    template<typename Q>
+    Node *lower(const Q &value) const {
+        std::size_t pos = _lower(value);
+        return pos ? tab_->towers[pos - 1] : nullptr;
+    }
+};
+
+// keys that cannot be searched without the comparator get no index
+template<typename Node, typename K, typename Alloc, int MaxLevel>
+class SLTopIndex<Node, K, Alloc, MaxLevel, false> {
+public:
+    static const bool enabled = false;
+    static const int max_entries = 0;
+    static const int min_size = 0;
+
+    void create(const Alloc &) {}
+    void destroy(const Alloc &) {}
+    bool built() const { return false; }
+    int level() const { return 0; }
+    int entries() const { return 0; }
+    int towers_at(int) const { return 0; }
+    void count(int, int) {}
+    void reset(int) {}
+    void push_back(const K &, Node *) {}
+    void insert(const K &, Node *) {}
+    void erase(const K &) {}
+    void erase(const K &, std::size_t) {}
+    template<typename Q>
+    Node *lower(const Q &) const { return nullptr; }
+};
+
+#endif
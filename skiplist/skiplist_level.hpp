@@ -0,0 +1,177 @@
+/*
+Level generation policies for the skiplist containers
+A policy decides how tall a new tower is
+*/
+#ifndef SKIPLIST_LEVEL_H
+#define SKIPLIST_LEVEL_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <ratio>
+
+// number of trailing zero bits, 64 for 0
+inline int _sl_ctz64(std::uint64_t bits) {
+    if(!bits)
+        return 64;
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(bits);
+#else
+    int zeros = 0;
+    while(!(bits & 1)) {
+        bits >>= 1;
+        ++zeros;
+    }
+    return zeros;
+#endif
+}
+
+// number of bits needed to write n down, 0 for 0
+inline int _sl_bit_width(std::size_t n) {
+    int bits = 0;
+    while(n) {
+        n >>= 1;
+        ++bits;
+    }
+    return bits;
+}
+
+// splitmix64 finalizer, scrambles a 64-bit value
+inline std::uint64_t _sl_mix64(std::uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Random engine for tower heights, 8 bytes of state (splitmix64).
+// Nothing happens when it is built: the first draw seeds it from a
+// process wide sequence, which itself asks std::random_device once.
+// So empty lists cost nothing and moved lists just keep their state.
+class SLRandom {
+private:
+    std::uint64_t state_;
+
+    static std::uint64_t _next_seed() {
+        static std::atomic<std::uint64_t> sequence(_first_seed());
+        return _sl_mix64(sequence.fetch_add(1, std::memory_order_relaxed));
+    }
+    static std::uint64_t _first_seed() {
+        std::random_device rd;
+        return ((std::uint64_t)rd() << 32) ^ rd();
+    }
+
+public:
+    using result_type = std::uint64_t;
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    SLRandom() : state_(0) {}
+
+    result_type operator()() {
+        // zero means not seeded yet
+        if(!state_)
+            state_ = _next_seed() | 1;
+        return _sl_mix64(state_ += 0x9E3779B97F4A7C15ull);
+    }
+};
+
+// A level policy is a functor taking a 64-bit random engine and
+// returning a height in [1, max_level]. Every level above the first
+// is kept with probability p.
+// level_limit(n) is the tallest tower worth building in a list of n
+// elements, about log_{1/p}(n) + 1. Anything taller only adds empty
+// levels every search has to walk down through.
+// ideal_height(i) is the height of the i-th tower (counting from 1) when
+// the towers are spaced out evenly instead of randomly, 1/p apart on the
+// second level, 1/p^2 on the third and so on. Lists built in one go from
+// sorted input can ask for that.
+
+// p = 1 / 2^LogInvP
+// The whole height comes out of a single 64-bit draw: every LogInvP
+// trailing zero bits is one more level.
+template<int LogInvP = 1, int MaxLevel = 32>
+struct SLGeometricLevels {
+    static_assert(LogInvP > 0, "p must be below 1");
+    static_assert(MaxLevel > 0, "towers have at least one level");
+    static const int max_level = MaxLevel;
+
+    template<typename URBG>
+    int operator()(URBG &gen) const {
+        static_assert(URBG::min() == 0 &&
+            URBG::max() == std::numeric_limits<std::uint64_t>::max(),
+            "needs an engine producing 64 random bits");
+        int height = 1 + _sl_ctz64(gen()) / LogInvP;
+        return height < MaxLevel ? height : MaxLevel;
+    }
+
+    static int level_limit(std::size_t n) {
+        int height = (_sl_bit_width(n) + LogInvP - 1) / LogInvP + 1;
+        return height < MaxLevel ? height : MaxLevel;
+    }
+
+    static int ideal_height(std::size_t i) {
+        int height = 1 + _sl_ctz64(i) / LogInvP;
+        return height < MaxLevel ? height : MaxLevel;
+    }
+};
+
+// p = P::num / P::den, for promotion probabilities that are not a power
+// of two (like 1/e). Each level is decided by 16 bits of a draw, so one
+// 64-bit draw covers four levels.
+template<typename P = std::ratio<1, 2>, int MaxLevel = 32>
+struct SLRatioLevels {
+    static_assert(P::num > 0 && P::num < P::den, "p must be in (0, 1)");
+    static_assert(MaxLevel > 0, "towers have at least one level");
+    static const int max_level = MaxLevel;
+
+    template<typename URBG>
+    int operator()(URBG &gen) const {
+        static_assert(URBG::min() == 0 &&
+            URBG::max() == std::numeric_limits<std::uint64_t>::max(),
+            "needs an engine producing 64 random bits");
+        // p scaled to 16 bits
+        const std::uint64_t threshold = (std::uint64_t)P::num * 65536 / P::den;
+        int height = 1;
+        while(height < MaxLevel) {
+            std::uint64_t bits = gen();
+            for(int i=0; i<4 && height < MaxLevel; i++, bits >>= 16) {
+                if((bits & 0xffff) >= threshold)
+                    return height;
+                ++height;
+            }
+        }
+        return height;
+    }
+
+    static int level_limit(std::size_t n) {
+        double left = (double)n;
+        int height = 1;
+        while(left >= 1 && height < MaxLevel) {
+            left = left * P::num / P::den;
+            ++height;
+        }
+        return height;
+    }
+
+    // 1/p rounded to the nearest whole spacing
+    static int ideal_height(std::size_t i) {
+        const std::size_t spacing = (P::den + P::num / 2) / P::num;
+        int height = 1;
+        while(height < MaxLevel && i % spacing == 0) {
+            i /= spacing;
+            ++height;
+        }
+        return height;
+    }
+};
+
+// the usual suspects
+template<int MaxLevel = 32>
+using SLHalfLevels = SLGeometricLevels<1, MaxLevel>;
+template<int MaxLevel = 32>
+using SLQuarterLevels = SLGeometricLevels<2, MaxLevel>;
+template<int MaxLevel = 32>
+using SLInvELevels = SLRatioLevels<std::ratio<367879, 1000000>, MaxLevel>;
+
+#endif
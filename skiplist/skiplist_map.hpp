@@ -10,84 +10,237 @@ Only the skiplist container should be visible
 #include <random>
 #include <iterator>
 #include <initializer_list>
+#include <new>
+#include <memory>
+#include <utility>
+#include <type_traits>
 
 #include <iomanip>
 #include <iostream>
 
+#include "skiplist_pool.hpp"
+#include "skiplist_level.hpp"
+#include "skiplist_compare.hpp"
+#include "skiplist_range.hpp"
+
 template<
     typename key_type,
     typename val_type,
-    typename compare_t = std::less<key_type>
+    typename compare_t = std::less<key_type>,
+    typename level_t = SLHalfLevels<>,
+    typename alloc_t = std::allocator<val_type>
 >
 class skiplist;
 
 template<
     typename key_type,
     typename val_type,
-    typename compare_t
+    typename compare_t,
+    typename level_t,
+    typename alloc_t
 >
-std::ostream &operator<<(std::ostream &out, const skiplist<key_type, val_type, compare_t>&);
+std::ostream &operator<<(std::ostream &out, const skiplist<key_type, val_type, compare_t, level_t, alloc_t>&);
+
+// A slot in the value arena, room for one mapped value
+template<typename V>
+struct SLValueSlot {
+    alignas(V) unsigned char raw[sizeof(V)];
+    static std::size_t bytes(int) { return sizeof(SLValueSlot); }
+};
+
+// Where the mapped values of a node are. The values themselves sit in
+// the map's value arena, the node only points at them: at the first one
+// directly, at the others (inserted under an equal key) through a vector
+// on the side, which is only allocated once there is a second one.
+template<typename V, typename Alloc>
+struct SLValueStore {
+    using vector_t = std::vector<V*, typename std::allocator_traits<Alloc>::template rebind_alloc<V*> >;
+    using vector_alloc_t = typename std::allocator_traits<Alloc>::template rebind_alloc<vector_t>;
+    using vector_traits = std::allocator_traits<vector_alloc_t>;
+
+    V *first;
+    vector_t *more;
+
+    SLValueStore() : first(nullptr), more(nullptr) {}
+    SLValueStore(const SLValueStore &) = delete;
+    SLValueStore &operator=(const SLValueStore &) = delete;
+    ~SLValueStore() { clear(); }
+
+    // value number i, in the order they were added
+    V *at(int i) const { return i ? (*more)[i - 1] : first; }
+
+    void push(V *value, const Alloc &alloc) {
+        if(!first) {
+            first = value;
+            return;
+        }
+        if(!more) {
+            vector_alloc_t vector_alloc(alloc);
+            more = new(vector_traits::allocate(vector_alloc, 1)) vector_t(alloc);
+        }
+        more->push_back(value);
+    }
+    // take out the most recent value
+    V *pop() {
+        if(!more) {
+            V *value = first;
+            first = nullptr;
+            return value;
+        }
+        V *value = more->back();
+        more->pop_back();
+        if(more->empty())
+            clear();
+        return value;
+    }
+    // take values from up to to out, in the order they came, leaving at
+    // least one, and hand each to drop
+    template<typename Drop>
+    void erase(int from, int to, Drop drop) {
+        for(int i=from; i<to; i++)
+            drop(at(i));
+        if(!from) {
+            first = (*more)[to - 1];
+            ++from;
+            ++to;
+        }
+        more->erase(more->begin() + (from - 1), more->begin() + (to - 1));
+        if(more->empty())
+            clear();
+    }
+    // the vector was made with its own allocator, so it can free itself
+    void clear() {
+        if(!more)
+            return;
+        vector_alloc_t vector_alloc(more->get_allocator());
+        more->~vector_t();
+        vector_traits::deallocate(vector_alloc, more, 1);
+        more = nullptr;
+    }
+};
 
-template<typename T, typename V = T>
+template<typename T, typename V = T, typename Alloc = std::allocator<V> >
 struct SLNode {
-    // Poorly named - left, right, up, down pointers
-    SLNode *back, *next, *up, *down;
+    // left pointer, only kept at level 0 since that is all iterators need
+    SLNode *back;
     // Value, should be templated
     T val;
-    // Storage for multiple elements
-    std::vector<V> valz;
-    // Count is integer only, will only be 0 for key nodes
+    // Where the mapped values are, see SLValueStore
+    SLValueStore<V, Alloc> values;
+    // Count is integer only
     int count;
-    SLNode(T val_)
-    : back(nullptr), next(nullptr), up(nullptr), down(nullptr), val(val_), count(1) {}
-    // TODO: not nice, T must have default constructor, must figure a workaround
-    SLNode()
-    : back(nullptr), next(nullptr), up(nullptr), down(nullptr), count(0) {}
-    
-    // Special copy constructor
-    SLNode(SLNode other, int)
-    : back(nullptr), next(nullptr), up(nullptr), down(nullptr), valz(other.valz) {
-        val = other.val;
-        count = other.count;
+    // number of levels this tower spans
+    int height;
+    // forward pointers, one per level.
+    // The node is over-allocated so that this holds `height` entries,
+    // the whole tower is a single allocation (same trick as leveldb)
+    SLNode *next[1];
+
+    // build a tower of height_ levels with memory from the pool,
+    // its key constructed in place from args
+    template<typename Pool, typename... Args>
+    static SLNode *create(Pool &pool, int height_, Args&&... args) {
+        void *mem = pool.allocate(height_);
+        return new(mem) SLNode(height_, std::forward<Args>(args)...);
+    }
+    template<typename Pool>
+    static void destroy(Pool &pool, SLNode *node) {
+        int height_ = node->height;
+        node->~SLNode();
+        pool.deallocate(node, height_);
+    }
+    // size of a tower with height_ levels
+    static std::size_t bytes(int height_) {
+        return sizeof(SLNode) + (height_ - 1) * sizeof(SLNode*);
+    }
+
+private:
+    template<typename... Args>
+    explicit SLNode(int height_, Args&&... args)
+    : back(nullptr), val(std::forward<Args>(args)...), count(1), height(height_) {
+        for(int i=0; i<height_; i++)
+            next[i] = nullptr;
     }
 };
 
 template<
     typename key_type,
     typename val_type,
-    typename compare_t
+    typename compare_t,
+    typename level_t,
+    typename alloc_t
 >
 class skiplist {
 private:
-    // header nodes for all levels
-    std::vector<SLNode<key_type, val_type>*> key;
+    using alloc_traits = std::allocator_traits<alloc_t>;
+    using node_alloc_t = typename alloc_traits::template rebind_alloc<val_type>;
+    using key_alloc_t = typename alloc_traits::template rebind_alloc<SLNode<key_type, val_type, alloc_t>*>;
+
+    // forward pointers out of the header, one per level.
+    // key[i] is the first node at level i
+    std::vector<SLNode<key_type, val_type, alloc_t>*, key_alloc_t> key;
     // number of nodes in the skiplist (including non-unique ones)
     int size_;
     // the last node at level 0
-    SLNode<key_type, val_type>* last;
-
-    // stuff required for random number generation
-    // see constructor for description/reference
-    std::mt19937_64 mt_;
-    std::uniform_real_distribution<double> dist_;
-
-    // template objects, since compare is supposed to be a functor
-    compare_t compare;
+    SLNode<key_type, val_type, alloc_t>* last;
+    // every tower lives in here
+    SLNodePool<SLNode<key_type, val_type, alloc_t>, level_t::max_level, node_alloc_t> pool_;
+    // and every mapped value in here, so searches only ever touch
+    // keys and links, and values never move once they are in
+    SLNodePool<SLValueSlot<val_type>, 1, node_alloc_t> values_;
+
+    // random numbers for tower heights, seeded on first use
+    SLRandom rng_;
+
+    // template objects, since compare is supposed to be a functor.
+    // wrapped so that three-way comparators work too, see skiplist_compare.hpp
+    SLCompare<compare_t> compare;
+    // picks the height of new towers, see skiplist_level.hpp
+    level_t levels;
+
+    // forward pointers leaving a node. nullptr stands in for the header
+    SLNode<key_type, val_type, alloc_t> **_links(SLNode<key_type, val_type, alloc_t> *node) {
+        return node ? node->next : key.data();
+    }
 
-    // setup random number generator and uniform
-    // distribution to help with probabilistic
-    // insertion.
-    void _setup_random_number_generator() {
-        // set up random number generator
-        // ref: https://stackoverflow.com/a/19666713/11199009
-        std::random_device rd;
-        // ref: https://www.cplusplus.com/reference/random/mt19937_64/
-        std::mt19937_64 mt(rd());
-        // usage of this is: dist(mt)
-        std::uniform_real_distribution<double> dist(0.0, 1.0);
+    // height of a new tower, as the level policy sees fit.
+    // never more than the policy thinks is useful for the current size
+    int _random_height() {
+        int height = levels(rng_), limit = level_t::level_limit(size_);
+        return height < limit ? height : limit;
+    }
 
-        this->mt_ = mt;
-        this->dist_ = dist;
+    // walk down from the top of the header, filling history with the
+    // last node before value at every level (nullptr for the header).
+    // returns the first node not less than value at level 0,
+    // and whether it is equal to value in equal, if given
+    SLNode<key_type, val_type, alloc_t> *_find_path(const key_type &value, SLNode<key_type, val_type, alloc_t> **history, bool *equal = nullptr);
+
+    // unlink a tower from every level and free it.
+    // history must hold its predecessors, as filled by _find_path
+    void _remove_node(SLNode<key_type, val_type, alloc_t> *node, SLNode<key_type, val_type, alloc_t> **history);
+    // the last node on every level (nullptr for the header), which is
+    // what _find_path would fill for a key past all of them
+    void _last_path(SLNode<key_type, val_type, alloc_t> **history);
+    // most towers _hint_path walks back over
+    static const int hint_steps = 16;
+    // history for a key that goes right before next (nullptr for the
+    // end), on its first levels: the towers before next tall enough for
+    // each, walking back along level 0 from next->back (or from last).
+    // false if that takes more than hint_steps towers
+    bool _hint_path(SLNode<key_type, val_type, alloc_t> *next, int levels, SLNode<key_type, val_type, alloc_t> **history);
+    // does value go right before next (nullptr for the end)?
+    // If so, equal is the tower on either side with the same key, if any
+    bool _at_hint(SLNode<key_type, val_type, alloc_t> *next, const key_type &value, SLNode<key_type, val_type, alloc_t> *&equal);
+
+    // a value in the arena, and back out of it
+    template<typename... Args>
+    val_type *_new_value(Args&&... args) {
+        return new(values_.allocate(1)) val_type(std::forward<Args>(args)...);
+    }
+    void _delete_value(val_type *value) {
+        value->~val_type();
+        values_.deallocate(value, 1);
     }
 
 public:
@@ -102,13 +255,19 @@ public:
     using const_reverse_iterator = cake_iterator<true>;
     using reverse_iterator = const_reverse_iterator;
 
-    skiplist() : size_(0), last(nullptr) {_setup_random_number_generator();}
+    skiplist() : size_(0), last(nullptr) {}
+
+    // every node, the key and the values come out of alloc
+    explicit skiplist(const alloc_t &alloc)
+    : key(key_alloc_t(alloc)), size_(0), last(nullptr), pool_(node_alloc_t(alloc)),
+      values_(node_alloc_t(alloc)) {}
 
     // iterator range is assumed to be valid.
     // can we validate range? no need, screw the user :)
     template<typename InputIterator>
-    skiplist(InputIterator first, InputIterator last): size_(0), last(nullptr) {
-        _setup_random_number_generator();
+    skiplist(InputIterator first, InputIterator last, const alloc_t &alloc = alloc_t())
+    : key(key_alloc_t(alloc)), size_(0), last(nullptr), pool_(node_alloc_t(alloc)),
+      values_(node_alloc_t(alloc)) {
         // last and size_ are taken care of during insertion.
         while(first != last) {
             insert(*first);
@@ -116,8 +275,9 @@ public:
         }
     }
 
-    skiplist(std::initializer_list<key_type> l) : size_(0), last(nullptr) {
-        _setup_random_number_generator();
+    skiplist(std::initializer_list<key_type> l, const alloc_t &alloc = alloc_t())
+    : key(key_alloc_t(alloc)), size_(0), last(nullptr), pool_(node_alloc_t(alloc)),
+      values_(node_alloc_t(alloc)) {
         auto first = l.begin();
         auto last = l.end();
         while(first != last) {
@@ -126,27 +286,38 @@ public:
         }
     }
 
-    // At every level, go on till nullptr and delete everything in its path
-    // then go on to the upper level
+    // Every tower shows up exactly once at level 0
+    // so walking that level runs every destructor.
+    // The memory itself goes back in one sweep over the slabs
     void destroy_all_levels() {
-        SLNode<key_type, val_type> *tmp;
-        for(auto level: key)
-            while(level) {
-                tmp = level->next;
-                delete level;
-                level = tmp;
-            }
+        SLNode<key_type, val_type, alloc_t> *tmp, *level = key.empty() ? nullptr : key[0];
+        while(level) {
+            tmp = level->next[0];
+            if(!std::is_trivially_destructible<val_type>::value)
+                for(int i=0; i<level->count; i++)
+                    level->values.at(i)->~val_type();
+            if(pool_.from_heap(level->height))
+                SLNode<key_type, val_type, alloc_t>::destroy(pool_, level);
+            else
+                level->~SLNode();
+            level = tmp;
+        }
+        pool_.release();
+        values_.release();
         key.clear();
+        last = nullptr;
     }
     
     ~skiplist() { destroy_all_levels(); }
 
     // move constructor
     skiplist(skiplist &&other) 
-    : key(other.key), size_(other.size_), last(other.last) {
-        _setup_random_number_generator();
+    : key(std::move(other.key)), size_(other.size_), last(other.last),
+      pool_(std::move(other.pool_)), values_(std::move(other.values_)), rng_(other.rng_) {
         // thief! thief! resources gon :(
         other.key.clear();
+        other.size_ = 0;
+        other.last = nullptr;
     }
 
     // move assignment. Apparently, this cannot be a friend :(
@@ -156,11 +327,23 @@ public:
         // what have you bought upon this cursed land?
             return *this;
 
-        // Ruthlessly STEAAAAL
         destroy_all_levels();
-        key = rhs.key;
+        // Nodes can only change hands if our allocator can free them
+        if(!alloc_traits::propagate_on_container_move_assignment::value
+           && get_allocator() != rhs.get_allocator()) {
+            perform_key_transfer(rhs);
+            size_ = rhs.size_;
+            rhs.destroy_all_levels();
+            rhs.size_ = 0;
+            return *this;
+        }
+
+        // Ruthlessly STEAAAAL
+        key = std::move(rhs.key);
         size_ = rhs.size_;
         last = rhs.last;
+        pool_ = std::move(rhs.pool_);
+        values_ = std::move(rhs.values_);
 
         rhs.key.clear();
         rhs.size_ = 0;
@@ -174,63 +357,39 @@ public:
     void perform_key_transfer(const skiplist &other) {
         if(other.key.empty())
             return;
-        
-        // map node pointers through s p a c e. has info about ...
-        // which node of L (i.e LHS) is holding the node from R (i.e. RHS)
-        // useful to map horizontal pointers between two levels
-        std::unordered_map<SLNode<key_type, val_type>*, SLNode<key_type, val_type>*> twister, jenga;
-        SLNode<key_type, val_type> *trav_r, *trav_l;
-        // handy, because all level 0 nodes have a down pointer to nullptr
-        jenga[nullptr] = nullptr;
-
-        // map level 0
-        // now map the higher levels
-        // oh chuck, just map them all
-        for(int i=0; i<other.key.size(); i++) {
-            
-            trav_r = other.key[i]->next;
-            trav_l = new SLNode<key_type, val_type>();
-            key.push_back(trav_l);
-            while(trav_r) {
-                trav_l->next = new SLNode<key_type, val_type>(*trav_r, 15081947);
-                trav_l->next->back = trav_l;
-                trav_l = trav_l->next;
-                
-                twister[trav_r] = trav_l;
-                // my favourite exit strategy :)
-                if(jenga.find(trav_r->down)==jenga.end()) {
-                    std::cout << "Should never see here! In Copy constructor\n";
-                    std::cout.flush();
-                    int *x(nullptr);
-                    *x = *x;
-                }
-                // continue with normal execution
-                trav_l->down = jenga[trav_r->down];
-                
-                if(trav_l->down)
-                    trav_l->down->up = trav_l;
-                
-                trav_r = trav_r->next;
-            }
-            // special case for level 0. need to get the last node pointer
-            if(i==0)
-                last = twister[other.last];
 
-            // move the current level pointers to the prev-level-pointer store
-            jenga = twister;
-            twister.clear();
-        }
-        // properly interleave the up down nodes of the key stack
-        for(int i=1; i<key.size(); i++) {
-            key[i]->down = key[i-1];
-            key[i-1]->up = key[i];
+        key.assign(other.key.size(), nullptr);
+        // the last tower built so far at every level, nullptr is the header.
+        // towers are copied in level 0 order, so each one just gets
+        // appended to the levels it spans
+        SLNode<key_type, val_type, alloc_t> *tails[level_t::max_level];
+        for(int i=0; i<(int)key.size(); i++)
+            tails[i] = nullptr;
+        SLNode<key_type, val_type, alloc_t> *trav_r, *trav_l;
+        for(trav_r = other.key[0]; trav_r; trav_r = trav_r->next[0]) {
+            trav_l = SLNode<key_type, val_type, alloc_t>::create(pool_, trav_r->height, trav_r->val);
+            for(int i=0; i<trav_r->count; i++)
+                trav_l->values.push(_new_value(*trav_r->values.at(i)), get_allocator());
+            trav_l->count = trav_r->count;
+            trav_l->back = tails[0];
+            for(int i=0; i<trav_l->height; i++) {
+                _links(tails[i])[i] = trav_l;
+                tails[i] = trav_l;
+            }
         }
+        last = tails[0];
     }
 
     // copy constructor
     skiplist(const skiplist &other) 
-    : size_(other.size_) {
-        _setup_random_number_generator();
+    : skiplist(other, alloc_traits::select_on_container_copy_construction(
+                          other.get_allocator())) {}
+
+    // copy constructor, with an allocator of our own
+    skiplist(const skiplist &other, const alloc_t &alloc)
+    : key(key_alloc_t(alloc)), size_(other.size_), last(nullptr),
+      pool_(node_alloc_t(alloc)),
+      values_(node_alloc_t(alloc)) {
         perform_key_transfer(other);
     }
 
@@ -245,49 +404,151 @@ public:
         destroy_all_levels();
         perform_key_transfer(rhs);
         size_ = rhs.size_;
-        last = rhs.last;
 
         return *this;
     }
 
     // specialized functions
-    void insert(key_type, val_type);
+    // the search goes by reference. the key is only copied (or moved)
+    // into a new tower, the value once into the value arena
+    void insert(const key_type &k, const val_type &v) { emplace(k, v); }
+    void insert(const key_type &k, val_type &&v) { emplace(k, std::move(v)); }
+    void insert(key_type &&k, val_type &&v) { emplace(std::move(k), std::move(v)); }
+    // the value is built right in the value arena, from args.
+    // returns an iterator to it.
+    // A key past the last one is linked in after the towers before the
+    // end without a search, in O(1) expected
+    template<typename K, typename... Args>
+    iterator emplace(K &&insert_key, Args&&... args);
+    // the same, and if the key goes right before hint its tower gets
+    // linked in from there in O(1) expected. A wrong hint costs two
+    // compares on top of emplace
+    template<typename K, typename... Args>
+    iterator emplace_hint(const_iterator hint, K &&insert_key, Args&&... args);
 
     // erase can be overloaded
     // this version finds the value and deletes the node if it exists
     // one more version of erase is passing an iterator object
-    void erase(key_type value);
+    void erase(const key_type &value);
     iterator erase(iterator it);
+    // erase [first, last), returns last. The towers in between come out
+    // of every level with one splice per level and are freed after,
+    // which is O(log n + k) for k towers
+    iterator erase(const_iterator first, const_iterator last);
+    // erase every value with a key in [lo, hi), returns how many went
+    int erase_range(const key_type &lo, const key_type &hi) { return _erase_range(lo, hi); }
+    template<typename K, typename X = compare_t, typename = typename X::is_transparent>
+    int erase_range(const K &lo, const K &hi) { return _erase_range(lo, hi); }
+    // with a transparent compare_t (one that has is_transparent, like
+    // std::less<>), lookups take anything compare_t can compare with
+    // key_type, so no key_type has to be built just to search for it.
+    // this one removes the most recent value under a key equal to k
+    template<typename K, typename X = compare_t, typename = typename X::is_transparent>
+    void erase(const K &k) {
+        auto it = find(k);
+        if(it != end())
+            erase(it);
+    }
 
-    iterator find(key_type value);
+    iterator find(const key_type &value) { return _find(value); }
+    template<typename K, typename X = compare_t, typename = typename X::is_transparent>
+    iterator find(const K &value) { return _find(value); }
     // smol count function to match set interface
 
-    int count(key_type value) {
+    int count(const key_type &value) {
         auto it = find(value);
         return  it != end() ? it.node->count : 0;
     }
-    friend std::ostream &operator<<<key_type, val_type, compare_t>(std::ostream &out, const skiplist<key_type, val_type, compare_t>& sl);
+    template<typename K, typename X = compare_t, typename = typename X::is_transparent>
+    int count(const K &value) {
+        auto it = find(value);
+        return  it != end() ? it.node->count : 0;
+    }
+
+    // first value with a key not less than value, end() if there is none
+    iterator lower_bound(const key_type &value) { return iterator(_bound(value, false)); }
+    template<typename K, typename X = compare_t, typename = typename X::is_transparent>
+    iterator lower_bound(const K &value) { return iterator(_bound(value, false)); }
+    // first value with a key greater than value, end() if there is none
+    iterator upper_bound(const key_type &value) { return iterator(_bound(value, true)); }
+    template<typename K, typename X = compare_t, typename = typename X::is_transparent>
+    iterator upper_bound(const K &value) { return iterator(_bound(value, true)); }
+    // [lower_bound, upper_bound) of value with one search: the values
+    // under a key share a tower, so the upper bound is right after it
+    std::pair<iterator, iterator> equal_range(const key_type &value) { return _equal_range(value); }
+    template<typename K, typename X = compare_t, typename = typename X::is_transparent>
+    std::pair<iterator, iterator> equal_range(const K &value) { return _equal_range(value); }
+    // the values with a key in [lo, hi), for a range-for.
+    // See skiplist_range.hpp
+    SLRange<iterator> range(const key_type &lo, const key_type &hi) { return _range(lo, hi); }
+    template<typename K, typename X = compare_t, typename = typename X::is_transparent>
+    SLRange<iterator> range(const K &lo, const K &hi) { return _range(lo, hi); }
+    friend std::ostream &operator<<<key_type, val_type, compare_t, level_t, alloc_t>(std::ostream &out, const skiplist<key_type, val_type, compare_t, level_t, alloc_t>& sl);
     int size() { return size_;}
+    alloc_t get_allocator() const { return alloc_t(pool_.get_allocator()); }
+    // slabs and free towers held by the node pool
+    SLPoolStats pool_stats() const { return pool_.stats(); }
+    // slabs and free slots held by the value arena
+    SLPoolStats value_stats() const { return values_.stats(); }
 
     // forward iterator to begin
-    iterator begin() { return key.empty() ? end() : iterator(key[0]->next); }
+    iterator begin() { return key.empty() ? end() : iterator(key[0]); }
     // forward iterator to one beyond last.
     iterator end() { return iterator(nullptr); };
     // reverse iterator pointing to last element
     reverse_iterator rbegin() { return reverse_iterator(last);}
-    // sneak trick -> if the list is empty, last will be a nullptr
-    // thus returning rbegin() is okay. it also provides good symmetry wrt begin
-    reverse_iterator rend() { return key.empty() ? rbegin() : reverse_iterator(key[0]);}
+    // the first node has no back pointer, so one beyond it is a nullptr
+    reverse_iterator rend() { return reverse_iterator(nullptr);}
     // constant forward iterator
-    const_iterator cbegin() { return key.empty() ? cend() : const_iterator(key[0]->next);}
+    const_iterator cbegin() { return key.empty() ? cend() : const_iterator(key[0]);}
     // constant forward iterator pointing to one beyond the last node
     const_iterator cend() { return const_iterator(nullptr); }
     // constant reverse iterator pointing to last element
     const_reverse_iterator crbegin() { return const_reverse_iterator(last); }
     // constant reverse iterator pointing to last one before the first node
-    const_reverse_iterator crend() {
-        return key.empty() ? crbegin() : const_reverse_iterator(key[0]); 
+    const_reverse_iterator crend() { return const_reverse_iterator(nullptr); }
+
+private:
+    // first node with a key equal to value, value being anything
+    // compare takes on the right of key_type
+    template<typename K>
+    iterator _find(const K &value);
+    // first tower with a key not less than value, or greater than it if upper
+    template<typename K>
+    SLNode<key_type, val_type, alloc_t> *_bound(const K &value, bool upper);
+    template<typename K>
+    std::pair<iterator, iterator> _equal_range(const K &value);
+    // [lower_bound(lo), lower_bound(hi)), empty if hi comes first
+    template<typename K>
+    SLRange<iterator> _range(const K &lo, const K &hi) {
+        iterator first = lower_bound(lo), last = lower_bound(hi);
+        if(!first.node || (last.node && compare(last.node->val, first.node->val)))
+            last = first;
+        return SLRange<iterator>(first, last);
+    }
+    template<typename K>
+    int _erase_range(const K &lo, const K &hi) {
+        int before = size_;
+        SLRange<iterator> doomed = _range(lo, hi);
+        erase(doomed.first, doomed.last);
+        return before - size_;
     }
+    // one more value for the key of node, returns an iterator to it
+    template<typename... Args>
+    iterator _push_value(SLNode<key_type, val_type, alloc_t> *node, Args&&... args);
+    // a new tower of height for insert_key and its first value, linked
+    // in after history, whose first levels must be filled
+    template<typename K, typename... Args>
+    iterator _link_new(int height, SLNode<key_type, val_type, alloc_t> **history, K &&insert_key, Args&&... args);
+    // take values from up to to of the ones in node out, at least one stays
+    void _drop_copies(SLNode<key_type, val_type, alloc_t> *node, int from, int to) {
+        node->values.erase(from, to, [this](val_type *value) { _delete_value(value); });
+        node->count -= to - from;
+        size_ -= to - from;
+    }
+    // unlink the towers from first up to stop (nullptr for the end)
+    // from every level and free them with their values
+    void _unlink_span(SLNode<key_type, val_type, alloc_t> *first, SLNode<key_type, val_type, alloc_t> *stop);
 };
 
 // Iterator always points to a level 0 node
@@ -295,10 +556,12 @@ public:
 template<
     typename key_type,
     typename val_type,
-    typename compare_t
+    typename compare_t,
+    typename level_t,
+    typename alloc_t
 >
 template<bool reversal>
-class skiplist<key_type, val_type, compare_t>::cake_iterator {
+class skiplist<key_type, val_type, compare_t, level_t, alloc_t>::cake_iterator {
 private:
     // since the skip list supports having non-unique elements with
     // the help of a count, to keep track of whether the iterator
@@ -318,9 +581,13 @@ private:
     // If true, the increment operations should move to node->back instead of node->next
     // Count calculations, technically, should not be affected I think
     bool reverse_;
-    // One edge case we need to take care of is a reverse ++ on the first node
-    // Instead of moving to nullptr, it will move to the key vector
-    // This is currently handled by rend and crend
+    // A reverse ++ on the first node moves to nullptr, since the first
+    // node has no back pointer. This is what rend and crend return
+
+    friend class skiplist;
+    // which of the node's values this is, the first being 0.
+    // an iterator that ran off the end keeps its old counts
+    int _index() const { return node ? node_count_ref_ - node_count_ : 0; }
 public:
     // types
     using difference_type = std::ptrdiff_t;
@@ -330,8 +597,8 @@ public:
     using iterator_category = std::bidirectional_iterator_tag;
     // To increment or decrement this iterator, just change node
     
-    SLNode<key_type, val_type> *node;
-    cake_iterator(SLNode<key_type, val_type> *node_) : node(node_) {
+    SLNode<key_type, val_type, alloc_t> *node;
+    cake_iterator(SLNode<key_type, val_type, alloc_t> *node_) : node(node_) {
         // check iterator constructor for explanation
         node_count_ = 0;
         node_count_ref_ = 0;
@@ -343,14 +610,14 @@ public:
         reverse_ = reversal;
     }
 
-    bool operator==(const cake_iterator &rhs) {
+    bool operator==(const cake_iterator &rhs) const {
         return node==rhs.node && node_count_ == rhs.node_count_;
     }
-    bool operator!=(const cake_iterator &rhs) { return !(*this==rhs); }
+    bool operator!=(const cake_iterator &rhs) const { return !(*this==rhs); }
     
     const val_type& operator*() const {
         // black magic. who's gonna read this anyway?
-        return node->valz[node_count_ref_ - node_count_];
+        return *node->values.at(node_count_ref_ - node_count_);
     }
     // pre-increment operator
     const cake_iterator& operator++() {
@@ -361,7 +628,7 @@ public:
         if(reverse_)
             node = node->back;
         else
-            node = node->next;
+            node = node->next[0];
         if(node) {
             node_count_ = node->count - 1;
             node_count_ref_ = node_count_;
@@ -382,7 +649,7 @@ public:
             return *this;
         }
         if(reverse_)
-            node = node->next;
+            node = node->next[0];
         else
             node = node->back;
         if(node) {
@@ -406,222 +673,378 @@ public:
 ================================================================================
 */
 
-// utility function to check equality, am lazy
-// https://twitter.com/acemarke/status/1072342186396667905
-template<typename T, typename op>
-bool _420_is_equal(T &a, T& b, op less_than) {
-    return !less_than(a, b) && !less_than(b, a);
+template<typename T, typename V, typename X, typename L, typename A>
+SLNode<T, V, A> *skiplist<T, V, X, L, A>::_find_path(const T &value, SLNode<T, V, A> **history, bool *equal) {
+    // Search always starts from the top of the header
+    SLNode<T, V, A> *follow = nullptr, *stop = nullptr, **links = key.data();
+    // how the last tower that stopped the walk compares with value
+    int stop_order = 1;
+    // Go on till level 0, moving right while the next tower is smaller.
+    // The tower that stopped the walk on one level is often the next one
+    // on the level below too, it gets compared with value only once
+    for(int level = (int)key.size() - 1; level >= 0; --level) {
+        while(links[level] && links[level] != stop) {
+            if(compare.three_way) {
+                int order = compare.order(links[level]->val, value);
+                if(order >= 0) {
+                    stop = links[level];
+                    stop_order = order;
+                    break;
+                }
+            }
+            else if(!compare(links[level]->val, value)) {
+                stop = links[level];
+                break;
+            }
+            follow = links[level];
+            links = follow->next;
+        }
+        history[level] = follow;
+    }
+    SLNode<T, V, A> *found = key.empty() ? nullptr : links[0];
+    // found is the last tower that stopped the walk, if there is one.
+    // a three-way compare already told whether it is equal
+    if(equal)
+        *equal = found && (compare.three_way ? stop_order == 0
+                                             : compare.equal_after_less(found->val, value));
+    return found;
 }
 
-template<typename T, typename V, typename X>
-// Inserting same will put it in a store and increment count
-// Insertion always starts at level 0
-void skiplist<T, V, X>::insert(T insert_key, V insert_value) {
-    ++size_;
+template<typename T, typename V, typename X, typename L, typename A>
+void skiplist<T, V, X, L, A>::_remove_node(SLNode<T, V, A> *node, SLNode<T, V, A> **history) {
+    // The tower is the next node of its predecessor on every level it spans
+    for(int level = 0; level < node->height; ++level)
+        _links(history[level])[level] = node->next[level];
+    if(node->next[0])
+        node->next[0]->back = node->back;
+    else
+        last = node->back;
+    SLNode<T, V, A>::destroy(pool_, node);
+    // Drop levels that became empty, so searches
+    // start from the highest level that has something in it
+    while(!key.empty() && !key.back())
+        key.pop_back();
+}
 
-    // If entire container empty
-    if(key.empty()) {
-        SLNode<T, V> *node = new SLNode<T, V>(insert_key);
-        SLNode<T, V> *keyd = new SLNode<T, V>();
-        key.push_back(keyd);
-        key[0]->next = node;
-        node->back = key[0];
-        last = node;
-        // Put the value into the store
-        node->valz.push_back(insert_value);
-        // Now insert some more, probabilistically
-        while(this->dist_(this->mt_) > 0.5) {
-            node->up = new SLNode<T, V>(insert_key);
-            node->up->down = node;
-            node = node->up;
-
-            keyd->up = new SLNode<T, V>();
-            keyd->up->down = keyd;
-            keyd = keyd->up;
-
-            keyd->next = node;
-            node->back = keyd;
-            key.push_back(keyd);
+template<typename T, typename V, typename X, typename L, typename A>
+void skiplist<T, V, X, L, A>::_last_path(SLNode<T, V, A> **history) {
+    SLNode<T, V, A> *follow = nullptr, **links = key.data();
+    for(int level = (int)key.size() - 1; level >= 0; --level) {
+        while(links[level]) {
+            follow = links[level];
+            links = follow->next;
         }
-        return;
+        history[level] = follow;
     }
-    // Else
-    // Find the correct position, insert
-    // If not exists, create upper levels for that element
+}
+
+template<typename T, typename V, typename X, typename L, typename A>
+// Inserting same will put it in a store and increment count
+// Insertion always starts at level 0
+template<typename K, typename... Args>
+typename skiplist<T, V, X, L, A>::iterator skiplist<T, V, X, L, A>::emplace(K &&insert_key, Args&&... args) {
+    ++size_;
 
     // This is the prev nodes for all levels
-    std::vector<SLNode<T, V>*> history;
-    // Search always starts from the upper left node
-    SLNode<T, V>* follow = key.back();
-    // Go on till level 0
-    while(follow->down) {
-        while(follow->next && compare(follow->next->val,insert_key))
-            follow = follow->next;
-        history.push_back(follow);
-        follow = follow->down;
-    }
-    // Traverse at level 0 till dest reached
-    while(follow->next && compare(follow->next->val,insert_key))
-        follow = follow->next;
+    // towers are never taller than max_level, so this fits on the stack
+    SLNode<T, V, A> *history[L::max_level];
+    const T &find_key = insert_key;
+    // Past the last key the path is the towers before the end,
+    // so appending in order is O(1) expected
+    if(last && compare(last->val, find_key)) {
+        int height = _random_height();
+        if(!_hint_path(nullptr, std::min(height, (int)key.size()), history))
+            _find_path(find_key, history);
+        return _link_new(height, history, std::forward<K>(insert_key), std::forward<Args>(args)...);
+    }
+    bool equal;
+    SLNode<T, V, A> *follow = _find_path(find_key, history, &equal);
 
     // If node already exists, add the new value to the store
-    if(follow->next && _420_is_equal(follow->next->val, insert_key, compare)) {
-        follow = follow->next;
-        follow->count++;
-        follow->valz.push_back(insert_value);
-        return;
-    }
+    if(equal)
+        return _push_value(follow, std::forward<Args>(args)...);
 
-    // Value does not exist. Insert a new node
-    SLNode<T, V> *node = new SLNode<T, V>(insert_key), *keyd = key.back();
-    node->next = follow->next;
-    node->back = follow;
-    if(follow->next)
-        follow->next->back = node;
-    follow->next = node;
-    if(!node->next)
-        last = node;
+    // Value does not exist. Insert a new tower, as tall as the coin says
+    return _link_new(_random_height(), history, std::forward<K>(insert_key), std::forward<Args>(args)...);
+}
+
+template<typename T, typename V, typename X, typename L, typename A>
+template<typename K, typename... Args>
+typename skiplist<T, V, X, L, A>::iterator skiplist<T, V, X, L, A>::emplace_hint(const_iterator hint, K &&insert_key, Args&&... args) {
+    const T &find_key = insert_key;
+    SLNode<T, V, A> *equal;
+    if(!_at_hint(hint.node, find_key, equal))
+        return emplace(std::forward<K>(insert_key), std::forward<Args>(args)...);
+    ++size_;
+    if(equal)
+        return _push_value(equal, std::forward<Args>(args)...);
+    SLNode<T, V, A> *history[L::max_level];
+    int height = _random_height();
+    // levels the list does not have yet are filled in by _link_new
+    if(!_hint_path(hint.node, std::min(height, (int)key.size()), history))
+        _find_path(find_key, history);
+    return _link_new(height, history, std::forward<K>(insert_key), std::forward<Args>(args)...);
+}
+
+template<typename T, typename V, typename X, typename L, typename A>
+template<typename... Args>
+typename skiplist<T, V, X, L, A>::iterator skiplist<T, V, X, L, A>::_push_value(SLNode<T, V, A> *node, Args&&... args) {
+    node->values.push(_new_value(std::forward<Args>(args)...), get_allocator());
+    node->count++;
+    // the new value is the last of its node
+    iterator it(node);
+    for(int i=1; i<node->count; i++)
+        ++it;
+    return it;
+}
+
+template<typename T, typename V, typename X, typename L, typename A>
+template<typename K, typename... Args>
+typename skiplist<T, V, X, L, A>::iterator skiplist<T, V, X, L, A>::_link_new(int height, SLNode<T, V, A> **history, K &&insert_key, Args&&... args) {
+    SLNode<T, V, A> *node = SLNode<T, V, A>::create(pool_, height, std::forward<K>(insert_key));
     // Add into storage
-    node->valz.push_back(insert_value);
-
-    // Probabilistically add more levels
-    while(this->dist_(this->mt_) > 0.5) {
-        node->up = new SLNode<T, V>(insert_key);
-        node->up->down = node;
-        node = node->up;
-        if(!history.empty()) {
-            node->next = history.back()->next;
-            node->back = history.back();
-            history.back()->next = node;
-            history.pop_back();
-        }
-        else {
-            // add directly to the key
-            // mess around with the pointers
-            keyd->up = new SLNode<T, V>();
-            keyd->up->down = keyd;
-            keyd = keyd->up;
-
-            keyd->next = node;
-            node->back = keyd;
-            key.push_back(keyd);
-        }
+    node->values.push(_new_value(std::forward<Args>(args)...), get_allocator());
+    // A tower taller than the list adds levels to the key.
+    // towers are capped by size, so this only happens O(log n) times
+    while((int)key.size() < node->height) {
+        history[key.size()] = nullptr;
+        key.push_back(nullptr);
+    }
+    for(int level = 0; level < node->height; ++level) {
+        SLNode<T, V, A> **links = _links(history[level]);
+        node->next[level] = links[level];
+        links[level] = node;
     }
+    node->back = history[0];
+    if(node->next[0])
+        node->next[0]->back = node;
+    else
+        last = node;
+    return iterator(node);
+}
+
+template<typename T, typename V, typename X, typename L, typename A>
+bool skiplist<T, V, X, L, A>::_at_hint(SLNode<T, V, A> *next, const T &value, SLNode<T, V, A> *&equal) {
+    SLNode<T, V, A> *pred = next ? next->back : last;
+    if((pred && compare(value, pred->val)) || (next && compare(next->val, value)))
+        return false;
+    // neither is greater than value, so not less is equal
+    equal = pred && !compare(pred->val, value) ? pred
+          : next && !compare(value, next->val) ? next : nullptr;
+    return true;
 }
 
-template<typename T, typename V, typename X>
+template<typename T, typename V, typename X, typename L, typename A>
+bool skiplist<T, V, X, L, A>::_hint_path(SLNode<T, V, A> *next, int levels, SLNode<T, V, A> **history) {
+    // Most towers are short, and the one before next is tall enough
+    // for the first level at least. nullptr is the header, which is
+    // on every level
+    SLNode<T, V, A> *pred = next ? next->back : last;
+    int level = 0;
+    for(int steps = 0; ; ++steps) {
+        while(level < levels && (!pred || pred->height > level))
+            history[level++] = pred;
+        if(level == levels)
+            return true;
+        if(steps == hint_steps)
+            return false;
+        pred = pred->back;
+    }
+}
+
+template<typename T, typename V, typename X, typename L, typename A>
 // Cannot assume element exists
-void skiplist<T, V, X>::erase(T erase_key) {
+void skiplist<T, V, X, L, A>::erase(const T &erase_key) {
     if(key.empty())
         return;
     // Find value
     // Decrement its counter
     // If counter is zero, remove it
     // If value does not exist, exit
-
-    // Start from top left
-    SLNode<T, V>* follow = key.back();
-    // Go on till level 0
-    while(follow->down) {
-        while(follow->next && compare(follow->next->val, erase_key))
-            follow = follow->next;
-        follow = follow->down;
-    }
-    // Traverse at level 0 till dest reached
-    while(follow->next && compare(follow->next->val, erase_key))
-        follow = follow->next;
+    SLNode<T, V, A> *history[L::max_level];
+    bool equal;
+    SLNode<T, V, A> *follow = _find_path(erase_key, history, &equal);
 
     // If not exist, leave
-    if(!follow->next || !_420_is_equal(follow->next->val, erase_key, compare))
+    if(!equal)
         return;
 
     // This is the node for sure
-    follow = follow->next;
-    follow->valz.pop_back();
+    _delete_value(follow->values.pop());
     follow->count--;
     --size_;
 
     if(follow->count)
         return;
     // Remove it if count is zero
-    last = follow->back;
-    SLNode<T, V> *tmp;
-    // Go up all levels of that node and delete them
-    while(follow) {
-        follow->back->next = follow->next;
-        if(follow->next)
-            follow->next->back = follow->back;
-        tmp = follow->up;
-        delete follow;
-        follow = tmp;
-    }
-    // TODO : We have decided to leave the key structure unaltered
-    // This means even if a level is empty, it is still preserved.
-    // Need to discuss the benefits / costs of doing that
-
-    // I don't think leaving it unaltered makes the implmentation incorrect...
-    // but please check that once if you come across unexpected behaviour later on
+    _remove_node(follow, history);
 }
 
-template<typename T, typename V, typename X>
+template<typename T, typename V, typename X, typename L, typename A>
 // Assume that iterator is valid
 // After erasing, move on to the next element
-typename skiplist<T, V, X>::iterator skiplist<T, V, X>::erase(typename skiplist<T, V, X>::iterator it) {
-    SLNode<T, V> *follow = it.node;
+typename skiplist<T, V, X, L, A>::iterator skiplist<T, V, X, L, A>::erase(typename skiplist<T, V, X, L, A>::iterator it) {
+    SLNode<T, V, A> *follow = it.node;
     // This is the node for sure
     follow->count--;
-    follow->valz.pop_back();
+    _delete_value(follow->values.pop());
     --size_;
 
     if(follow->count)
         return it;
 
     // Remove it if count is zero
-    last = follow->back;
-    SLNode<T, V> *tmp, *ret(follow->next);
-    // Go up all levels of that node and delete them
-    while(follow) {
-        follow->back->next = follow->next;
-        if(follow->next)
-            follow->next->back = follow->back;
-        tmp = follow->up;
-        delete follow;
-        follow = tmp;
-    }
+    // Towers only know what comes after them, so look up the predecessors
+    SLNode<T, V, A> *history[L::max_level];
+    _find_path(follow->val, history);
+    SLNode<T, V, A> *ret(follow->next[0]);
+    _remove_node(follow, history);
     return iterator(ret);
-    // NOTE: If there are bugs in this function due to layer management
-    // check the erase function above for explanantion and fixes
 }
 
-template<typename T, typename V, typename X>
-typename skiplist<T, V, X>::iterator skiplist<T, V, X>::find(T find_key) {
+template<typename T, typename V, typename X, typename L, typename A>
+template<typename K>
+typename skiplist<T, V, X, L, A>::iterator skiplist<T, V, X, L, A>::_find(const K &find_key) {
     // Same algorithm as erase, but without erasing anything ;)
     if(key.empty())
         return end();
 
     // Start from top left
-    SLNode<T, V>* follow = key.back();
-    // Go on till level 0
-    while(follow->down) {
-        while(follow->next && compare(follow->next->val, find_key))
-            follow = follow->next;
-        follow = follow->down;
+    SLNode<T, V, A> *follow = nullptr, **links = key.data();
+    // Go on till level 0, dropping a level inside the same tower.
+    // A tower that stopped the walk is not compared again a level down
+    SLNode<T, V, A> *stop = nullptr;
+    for(int level = (int)key.size() - 1; level >= 0; --level) {
+        while(links[level] && links[level] != stop) {
+            if(compare.three_way) {
+                int order = compare.order(links[level]->val, find_key);
+                // there is one tower per key, so this is it
+                if(order == 0)
+                    return iterator(links[level]);
+                if(order > 0) {
+                    stop = links[level];
+                    break;
+                }
+            }
+            else if(!compare(links[level]->val, find_key)) {
+                stop = links[level];
+                break;
+            }
+            follow = links[level];
+            links = follow->next;
+        }
     }
-    // Traverse at level 0 till dest reached
-    while(follow->next && compare(follow->next->val, find_key))
-        follow = follow->next;
+    // a three-way compare would have seen an equal tower on the way
+    if(compare.three_way)
+        return end();
+    follow = links[0];
 
     // If not exist, leave
-    if(!follow->next || !_420_is_equal(follow->next->val, find_key, compare))
+    if(!follow || !compare.equal_after_less(follow->val, find_key))
         return end();
 
     // This is the node for sure
-    follow = follow->next;
     return iterator(follow);
 }
 
-template<typename T, typename V, typename X>
-std::ostream &operator<<(std::ostream &out, const skiplist<T, V, X>& sl) {
+template<typename T, typename V, typename X, typename L, typename A>
+template<typename K>
+SLNode<T, V, A> *skiplist<T, V, X, L, A>::_bound(const K &value, bool upper) {
+    if(key.empty())
+        return nullptr;
+    // Same walk as _find, moving right past towers less than value,
+    // or for upper, not greater than it
+    SLNode<T, V, A> *follow = nullptr, *stop = nullptr, **links = key.data();
+    for(int level = (int)key.size() - 1; level >= 0; --level) {
+        while(links[level] && links[level] != stop) {
+            bool before;
+            if(compare.three_way) {
+                int order = compare.order(links[level]->val, value);
+                before = upper ? order <= 0 : order < 0;
+            }
+            else
+                before = upper ? !compare(value, links[level]->val) : compare(links[level]->val, value);
+            if(!before) {
+                stop = links[level];
+                break;
+            }
+            follow = links[level];
+            links = follow->next;
+        }
+    }
+    return links[0];
+}
+
+template<typename T, typename V, typename X, typename L, typename A>
+template<typename K>
+std::pair<typename skiplist<T, V, X, L, A>::iterator, typename skiplist<T, V, X, L, A>::iterator>
+skiplist<T, V, X, L, A>::_equal_range(const K &value) {
+    SLNode<T, V, A> *first = _bound(value, false), *last = first;
+    // one tower per key for key_type, a transparent compare may
+    // find a few more equal to value
+    while(last && !compare(value, last->val))
+        last = last->next[0];
+    return std::make_pair(iterator(first), iterator(last));
+}
+
+template<typename T, typename V, typename X, typename L, typename A>
+typename skiplist<T, V, X, L, A>::iterator skiplist<T, V, X, L, A>::erase(const_iterator first, const_iterator last) {
+    SLNode<T, V, A> *head = first.node, *stop = last.node;
+    const int from = first._index(), to = last._index();
+    // Both ends in one tower, only values go
+    if(head == stop) {
+        if(head && to > from)
+            _drop_copies(head, from, to);
+        iterator it(head);
+        for(int i=0; i<from; i++)
+            ++it;
+        return it;
+    }
+    // A tower the range only covers part of keeps the values outside it
+    if(from) {
+        _drop_copies(head, from, head->count);
+        head = head->next[0];
+    }
+    if(to)
+        _drop_copies(stop, 0, to);
+    if(head != stop)
+        _unlink_span(head, stop);
+    return iterator(stop);
+}
+
+template<typename T, typename V, typename X, typename L, typename A>
+void skiplist<T, V, X, L, A>::_unlink_span(SLNode<T, V, A> *first, SLNode<T, V, A> *stop) {
+    // The predecessors of first and of stop on every level. Where they
+    // differ, the towers in between are on that level, and the
+    // predecessor of first gets linked straight to what comes after them
+    SLNode<T, V, A> *before[L::max_level], *after[L::max_level];
+    _find_path(first->val, before);
+    if(stop)
+        _find_path(stop->val, after);
+    else
+        _last_path(after);
+    for(int level = 0; level < (int)key.size(); ++level)
+        if(before[level] != after[level])
+            _links(before[level])[level] = after[level]->next[level];
+    if(stop)
+        stop->back = before[0];
+    else
+        last = before[0];
+    while(!key.empty() && !key.back())
+        key.pop_back();
+    // Level 0 of the span is still linked up, free it in one sweep
+    while(first != stop) {
+        SLNode<T, V, A> *next = first->next[0];
+        size_ -= first->count;
+        for(int i=0; i<first->count; i++)
+            _delete_value(first->values.pop());
+        SLNode<T, V, A>::destroy(pool_, first);
+        first = next;
+    }
+}
+
+template<typename T, typename V, typename X, typename L, typename A>
+std::ostream &operator<<(std::ostream &out, const skiplist<T, V, X, L, A>& sl) {
     if (sl.key.empty()) {
         return out << "EMPTY SKIPLIST" << std::endl;
     }
@@ -629,30 +1052,27 @@ std::ostream &operator<<(std::ostream &out, const skiplist<T, V, X>& sl) {
     out << "Values: ";
     // store mapping of node->index in a map
     std::map<T, int> index_store{};
-    auto bottom_it = (*(sl.key.begin()))->next;
+    auto bottom_it = sl.key[0];
     int cur_index = 0;
     while (bottom_it) {
-        for (auto value : bottom_it->valz) {
-          out << value << ", ";
+        for (int i = 0; i < bottom_it->count; ++i) {
+          out << *bottom_it->values.at(i) << ", ";
         }
 
         index_store[bottom_it->val] = cur_index;
         cur_index++;
-        bottom_it = bottom_it->next;
+        bottom_it = bottom_it->next[0];
     }
     out << std::endl;
 
-    auto level = sl.key.rbegin();
-    auto end = sl.key.rend();
-    while(level != end) {
+    for (int level = (int)sl.key.size() - 1; level >= 0; --level) {
         // S denotes start of level, could be something different
         out << "S";
 
         // to store previous element's index
         // and current element's index
         int index = -1, next_index;
-        // skip the first element - it is always 0
-        auto it = (*level)->next;
+        auto it = sl.key[level];
         // iterate through the list at this level
         while (it) {
             next_index = index_store[it->val];
@@ -666,7 +1086,7 @@ std::ostream &operator<<(std::ostream &out, const skiplist<T, V, X>& sl) {
             // width of printed element is hardcoded to 3 for now
             // the padding is filled with ""-"
             out << "-" << std::setfill('-') << std::setw(3) << it->val;
-            it = it->next;
+            it = it->next[level];
 
             index = next_index;
         }
@@ -679,13 +1099,28 @@ std::ostream &operator<<(std::ostream &out, const skiplist<T, V, X>& sl) {
         out << "-E";
 
         out << std::endl;
-
-        level++;
     }
 
     return out;
 }
 // End of cpp file
 
+// skiplist on a std::pmr::memory_resource, C++17 onwards
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+namespace pmr {
+template<
+    typename key_type,
+    typename val_type,
+    typename compare_t = std::less<key_type>,
+    typename level_t = SLHalfLevels<>
+>
+using skiplist = ::skiplist<key_type, val_type, compare_t, level_t,
+                            std::pmr::polymorphic_allocator<val_type> >;
+}
+#endif
+#endif
+
 #endif
 // End of header file
@@ -0,0 +1,365 @@
+/*
+Node pool for the skiplist containers
+Towers are carved out of slabs instead of going to the global heap
+*/
+#ifndef SKIPLIST_POOL_H
+#define SKIPLIST_POOL_H
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+// what a pool is holding on to, see SLNodePool::stats
+struct SLPoolStats {
+    // number of slabs allocated so far
+    std::size_t slabs;
+    // bytes held in those slabs
+    std::size_t bytes;
+    // towers that can be handed out without allocating another slab
+    std::size_t free_nodes;
+};
+
+// Slab allocator for towers of a skiplist.
+// Towers of the same height have the same size, so every height gets its
+// own size class with its own slabs and its own free list.
+// Erased towers go on the free list of their class and are handed out
+// again by the next insert of that height. Slabs are only given back all
+// at once, in release(), which is what makes tearing down a big list cheap.
+// Towers taller than Classes levels are rare enough to get memory of their own.
+// All memory comes from Alloc, rebound to slab sized units.
+// Nothing is allocated till the first tower, so an empty pool is an
+// allocator and a pointer.
+// Towers can move to another list without being copied: the pool of that
+// list then adopts the slabs they are in, or gets a share of them when
+// both lists keep towers there, see adopt and share.
+template<typename Node, int Classes = 32, typename Alloc = std::allocator<char> >
+class SLNodePool {
+private:
+    // slabs are chained through their first bytes.
+    // memory is handed out in units of this size, which keeps
+    // the towers after the header aligned
+    struct alignas(std::max_align_t) Slab {
+        Slab *next;
+        std::size_t units;
+    };
+    // slabs that more than one pool may hold on to, freed by whichever
+    // lets go of them last. The count is atomic, so the lists that
+    // share them can live on different threads
+    struct Arena {
+        std::atomic<std::size_t> refs;
+        Slab *slabs;
+
+        explicit Arena(Slab *slabs_) : refs(1), slabs(slabs_) {}
+    };
+    // the arenas a pool holds on to, chained
+    struct Ref {
+        Arena *arena;
+        Ref *next;
+    };
+    using slab_alloc_t = typename std::allocator_traits<Alloc>::template rebind_alloc<Slab>;
+    using slab_traits = std::allocator_traits<slab_alloc_t>;
+    // erased towers are chained through their first bytes
+    struct FreeNode {
+        FreeNode *next;
+    };
+    // per size class: free list, the slab being carved and how big the next one is
+    struct Class {
+        FreeNode *free;
+        char *cur, *end;
+        std::size_t slab_nodes, nfree;
+    };
+    // everything the pool keeps track of, followed by nclasses Class entries.
+    // only holds classes up to the tallest tower seen so far, which stays
+    // small for small lists since their towers are capped by size
+    struct Block {
+        Slab *slabs;
+        Ref *arenas;
+        std::size_t nslabs, bytes;
+        int nclasses;
+        Class *classes() { return reinterpret_cast<Class*>(this + 1); }
+    };
+
+    // slabs start small so tiny lists stay tiny,
+    // then double till they hit this many bytes
+    static const std::size_t max_slab_bytes = 64 * 1024;
+    static const std::size_t first_slab_nodes = 4;
+
+    slab_alloc_t alloc_;
+    Block *blk_;
+
+    // size of a tower in class c, rounded so the next one stays aligned
+    static std::size_t _node_bytes(int c) {
+        std::size_t bytes = Node::bytes(c + 1), align = alignof(Node);
+        if(bytes < sizeof(FreeNode))
+            bytes = sizeof(FreeNode);
+        return (bytes + align - 1) / align * align;
+    }
+
+    // units needed to hold bytes
+    static std::size_t _units(std::size_t bytes) {
+        return (bytes + sizeof(Slab) - 1) / sizeof(Slab);
+    }
+    static std::size_t _block_units(int nclasses) {
+        return _units(sizeof(Block) + nclasses * sizeof(Class));
+    }
+
+    // make room for classes up to height, moving the block if needed
+    void _reserve(int height) {
+        int old = blk_ ? blk_->nclasses : 0, n = old * 2;
+        if(n < height)
+            n = height;
+        if(n > Classes)
+            n = Classes;
+        Block *blk = reinterpret_cast<Block*>(slab_traits::allocate(alloc_, _block_units(n)));
+        if(blk_) {
+            *blk = *blk_;
+            for(int c=0; c<old; c++)
+                blk->classes()[c] = blk_->classes()[c];
+            slab_traits::deallocate(alloc_, reinterpret_cast<Slab*>(blk_), _block_units(old));
+        }
+        else {
+            blk->slabs = nullptr;
+            blk->arenas = nullptr;
+            blk->nslabs = blk->bytes = 0;
+        }
+        blk->nclasses = n;
+        for(int c=old; c<n; c++) {
+            Class empty = {nullptr, nullptr, nullptr, first_slab_nodes, 0};
+            blk->classes()[c] = empty;
+        }
+        blk_ = blk;
+    }
+
+    // memory for the bookkeeping of arenas, from the same allocator
+    template<typename U>
+    U *_make() { return reinterpret_cast<U*>(slab_traits::allocate(alloc_, _units(sizeof(U)))); }
+    template<typename U>
+    void _free(U *ptr) { slab_traits::deallocate(alloc_, reinterpret_cast<Slab*>(ptr), _units(sizeof(U))); }
+
+    void _free_slabs(Slab *slab) {
+        while(slab) {
+            Slab *next = slab->next;
+            slab_traits::deallocate(alloc_, slab, slab->units);
+            slab = next;
+        }
+    }
+    // is arena one of ours already? a pool holds each arena once
+    bool _holds(const Arena *arena) const {
+        for(Ref *ref = blk_->arenas; ref; ref = ref->next)
+            if(ref->arena == arena)
+                return true;
+        return false;
+    }
+    void _hold(Arena *arena) {
+        Ref *ref = _make<Ref>();
+        ref->arena = arena;
+        ref->next = blk_->arenas;
+        blk_->arenas = ref;
+    }
+    // the slabs so far become an arena, held by this pool alone for now.
+    // Towers keep being carved out of them and put back on the free lists
+    void _seal() {
+        if(!blk_->slabs)
+            return;
+        _hold(new(_make<Arena>()) Arena(blk_->slabs));
+        blk_->slabs = nullptr;
+    }
+
+    void _move_allocator(SLNodePool &other, std::true_type) {
+        alloc_ = std::move(other.alloc_);
+    }
+    void _move_allocator(SLNodePool &, std::false_type) {}
+
+    // get a fresh slab for class c
+    void _grow(int c) {
+        Class &cls = blk_->classes()[c];
+        std::size_t node = _node_bytes(c);
+        std::size_t units = 1 + _units(node * cls.slab_nodes);
+        Slab *slab = slab_traits::allocate(alloc_, units);
+        slab->next = blk_->slabs;
+        slab->units = units;
+        blk_->slabs = slab;
+        ++blk_->nslabs;
+        blk_->bytes += units * sizeof(Slab);
+
+        cls.cur = reinterpret_cast<char*>(slab + 1);
+        cls.end = cls.cur + node * cls.slab_nodes;
+        if(node * cls.slab_nodes * 2 <= max_slab_bytes)
+            cls.slab_nodes *= 2;
+    }
+
+public:
+    explicit SLNodePool(const Alloc &alloc = Alloc()) : alloc_(alloc), blk_(nullptr) {}
+    ~SLNodePool() { release(); }
+
+    // a pool owns its slabs, so it can only be moved around
+    SLNodePool(const SLNodePool &) = delete;
+    SLNodePool &operator=(const SLNodePool &) = delete;
+    SLNodePool(SLNodePool &&other) : alloc_(std::move(other.alloc_)), blk_(other.blk_) {
+        other.blk_ = nullptr;
+    }
+    // the allocators must either be equal or propagate on move assignment,
+    // otherwise slabs would be freed by an allocator that did not make them
+    SLNodePool &operator=(SLNodePool &&other) {
+        if(this != &other) {
+            release();
+            _move_allocator(other,
+                typename slab_traits::propagate_on_container_move_assignment());
+            blk_ = other.blk_;
+            other.blk_ = nullptr;
+        }
+        return *this;
+    }
+
+    Alloc get_allocator() const { return Alloc(alloc_); }
+
+    // memory for a tower with height levels
+    void *allocate(int height) {
+        if(height > Classes)
+            return slab_traits::allocate(alloc_, _units(Node::bytes(height)));
+        if(!blk_ || blk_->nclasses < height)
+            _reserve(height);
+        Class &cls = blk_->classes()[height - 1];
+        if(cls.free) {
+            FreeNode *node = cls.free;
+            cls.free = node->next;
+            --cls.nfree;
+            return node;
+        }
+        if(cls.cur == cls.end)
+            _grow(height - 1);
+        void *node = cls.cur;
+        cls.cur += _node_bytes(height - 1);
+        return node;
+    }
+
+    // give back the memory of a tower, it will be reused by its class
+    void deallocate(void *ptr, int height) {
+        if(height > Classes) {
+            slab_traits::deallocate(alloc_, static_cast<Slab*>(ptr),
+                                    _units(Node::bytes(height)));
+            return;
+        }
+        // a tower that came from another pool may be taller than any here
+        if(!blk_ || blk_->nclasses < height)
+            _reserve(height);
+        Class &cls = blk_->classes()[height - 1];
+        FreeNode *node = static_cast<FreeNode*>(ptr);
+        node->next = cls.free;
+        cls.free = node;
+        ++cls.nfree;
+    }
+
+    // does deallocate need to be called for towers this tall
+    // before a release()? only the ones that bypassed the slabs
+    static bool from_heap(int height) { return height > Classes; }
+
+    // Can towers from other be given back to this pool, and slabs
+    // change hands between the two? Only if the allocators are equal
+    bool compatible(const SLNodePool &other) const { return alloc_ == other.alloc_; }
+
+    // Take over every slab and free tower of other, which is left empty.
+    // The towers in other's slabs can then be kept or freed here.
+    // The allocators must be compatible. Costs O(1) plus a step for
+    // every free tower of other, and one per arena of other for each
+    // arena here
+    void adopt(SLNodePool &other) {
+        if(!other.blk_ || this == &other)
+            return;
+        if(!blk_) {
+            blk_ = other.blk_;
+            other.blk_ = nullptr;
+            return;
+        }
+        other._seal();
+        if(blk_->nclasses < other.blk_->nclasses)
+            _reserve(other.blk_->nclasses);
+        for(Ref *ref = other.blk_->arenas, *next; ref; ref = next) {
+            next = ref->next;
+            // an arena both pools hold, as after a split and a join back,
+            // stays held once. Ours keeps the count above zero
+            if(_holds(ref->arena)) {
+                ref->arena->refs.fetch_sub(1, std::memory_order_relaxed);
+                other._free(ref);
+                continue;
+            }
+            ref->next = blk_->arenas;
+            blk_->arenas = ref;
+        }
+        for(int c=0; c<other.blk_->nclasses; c++) {
+            Class &mine = blk_->classes()[c], &theirs = other.blk_->classes()[c];
+            if(theirs.free) {
+                FreeNode *end = theirs.free;
+                while(end->next)
+                    end = end->next;
+                end->next = mine.free;
+                mine.free = theirs.free;
+                mine.nfree += theirs.nfree;
+            }
+            // the rest of their slab, unless ours still has room
+            if(mine.cur == mine.end) {
+                mine.cur = theirs.cur;
+                mine.end = theirs.end;
+            }
+        }
+        blk_->nslabs += other.blk_->nslabs;
+        blk_->bytes += other.blk_->bytes;
+        slab_traits::deallocate(other.alloc_, reinterpret_cast<Slab*>(other.blk_), _block_units(other.blk_->nclasses));
+        other.blk_ = nullptr;
+    }
+
+    // Let other keep every slab of this pool alive too, for towers that
+    // move over to other while the rest stay here. Neither pool frees
+    // the slabs till both have let go of them.
+    // The allocators must be compatible. Costs a step per arena of this
+    // pool for each arena of other
+    void share(SLNodePool &other) {
+        if(!blk_ || this == &other)
+            return;
+        _seal();
+        if(!other.blk_)
+            other._reserve(1);
+        for(Ref *ref = blk_->arenas; ref; ref = ref->next) {
+            if(other._holds(ref->arena))
+                continue;
+            ref->arena->refs.fetch_add(1, std::memory_order_relaxed);
+            other._hold(ref->arena);
+        }
+    }
+
+    // free every slab in one go. towers still alive become garbage.
+    // slabs shared with another pool stay till that one lets go too
+    void release() {
+        if(!blk_)
+            return;
+        _free_slabs(blk_->slabs);
+        while(blk_->arenas) {
+            Ref *ref = blk_->arenas;
+            blk_->arenas = ref->next;
+            if(ref->arena->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                _free_slabs(ref->arena->slabs);
+                ref->arena->~Arena();
+                _free(ref->arena);
+            }
+            _free(ref);
+        }
+        slab_traits::deallocate(alloc_, reinterpret_cast<Slab*>(blk_), _block_units(blk_->nclasses));
+        blk_ = nullptr;
+    }
+
+    SLPoolStats stats() const {
+        SLPoolStats s = {0, 0, 0};
+        if(!blk_)
+            return s;
+        s.slabs = blk_->nslabs;
+        s.bytes = blk_->bytes;
+        for(int c=0; c<blk_->nclasses; c++) {
+            const Class &cls = blk_->classes()[c];
+            s.free_nodes += cls.nfree + (cls.end - cls.cur) / _node_bytes(c);
+        }
+        return s;
+    }
+};
+
+#endif
@@ -0,0 +1,21 @@
+/*
+View of a run of elements of a skiplist container
+What range(lo, hi) gives back, to go over with a range-for
+*/
+#ifndef SKIPLIST_RANGE_H
+#define SKIPLIST_RANGE_H
+
+// The elements in [first, last) of a list. Holds nothing but the two
+// iterators, so it stays valid as long as those do
+template<typename Iterator>
+struct SLRange {
+    Iterator first, last;
+
+    SLRange(Iterator first_, Iterator last_) : first(first_), last(last_) {}
+
+    Iterator begin() const { return first; }
+    Iterator end() const { return last; }
+    bool empty() const { return first == last; }
+};
+
+#endif
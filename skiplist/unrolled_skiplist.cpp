@@ -0,0 +1,12 @@
+/*
+unrolled skiplist container implemenation
+*/
+#include "unrolled_skiplist.hpp"
+
+/*
+unfortunately, cpp doesn't like templates being defined across two files:
+http://www.cplusplus.com/forum/beginner/214364/
+if anyone finds a good way to split the interface and implementation across
+a header and a cpp file, please copy the code from the header file and paste it 
+here. :(
+*/
@@ -0,0 +1,615 @@
+/*
+Unrolled skip list implementation
+Same interface as skiplist, but level 0 is a list of small sorted blocks
+of elements instead of one node per element
+*/
+#ifndef UNROLLED_SKIPLIST_H
+#define UNROLLED_SKIPLIST_H
+#include <iterator>
+#include <initializer_list>
+#include <new>
+#include <memory>
+#include <utility>
+#include <algorithm>
+
+#include "skiplist_pool.hpp"
+#include "skiplist_level.hpp"
+
+// Elements per block: about two cache lines worth, between 8 and 64.
+// Specialize to change that for a type
+template<typename T>
+struct SLBlockSize {
+    static const int value = 128 / sizeof(T) < 8 ? 8
+                           : 128 / sizeof(T) > 64 ? 64 : int(128 / sizeof(T));
+};
+
+// A block of up to Capacity sorted elements, which is also a tower.
+// Elements are kept packed at the front of the block. The block is
+// found through its first element, the only one the upper levels see.
+template<typename T, int Capacity>
+struct SLBlock {
+    // previous block at level 0
+    SLBlock *back;
+    // number of elements in the block
+    int count;
+    // number of levels this tower spans
+    int height;
+    // room for the elements, only the first count are alive
+    alignas(T) unsigned char raw[Capacity * sizeof(T)];
+    // forward pointers, over-allocated like the ones of SLNode
+    SLBlock *next[1];
+
+    T *vals() { return reinterpret_cast<T*>(raw); }
+    const T *vals() const { return reinterpret_cast<const T*>(raw); }
+
+    template<typename Pool>
+    static SLBlock *create(Pool &pool, int height_) {
+        return new(pool.allocate(height_)) SLBlock(height_);
+    }
+    template<typename Pool>
+    static void destroy(Pool &pool, SLBlock *blk) {
+        int height_ = blk->height;
+        blk->~SLBlock();
+        pool.deallocate(blk, height_);
+    }
+    static std::size_t bytes(int height_) {
+        return sizeof(SLBlock) + (height_ - 1) * sizeof(SLBlock*);
+    }
+
+    ~SLBlock() {
+        for(int i=0; i<count; i++)
+            vals()[i].~T();
+    }
+
+private:
+    explicit SLBlock(int height_) : back(nullptr), count(0), height(height_) {
+        for(int i=0; i<height_; i++)
+            next[i] = nullptr;
+    }
+};
+
+// Blocks fill up to block_size elements, then split in two halves.
+// One that drops below a quarter full gets merged with a neighbour when
+// the two fit in one block. Only blocks get towers, so the upper levels
+// hold one entry per block rather than per element, and walking the
+// list in order touches one block after the other.
+// Equal elements are kept in insertion order, like in compact_skiplist.
+template<
+    typename val_type,
+    typename compare_t = std::less<val_type>,
+    typename level_t = SLHalfLevels<>,
+    typename alloc_t = std::allocator<val_type>,
+    int block_size = SLBlockSize<val_type>::value
+>
+class unrolled_skiplist {
+private:
+    static_assert(block_size >= 4, "blocks must be able to split and merge");
+
+    using block_t = SLBlock<val_type, block_size>;
+    using alloc_traits = std::allocator_traits<alloc_t>;
+
+    // first block of every level, only the first levels_ entries are used
+    block_t *key[level_t::max_level];
+    int levels_;
+    // number of elements in the skiplist (including non-unique ones)
+    int size_;
+    // number of blocks, which is what the towers are built over
+    int blocks_;
+    // the last block at level 0
+    block_t *last;
+    // every block lives in here
+    SLNodePool<block_t, level_t::max_level, alloc_t> pool_;
+
+    // random numbers for tower heights, seeded on first use
+    SLRandom rng_;
+
+    // template objects, since compare is supposed to be a functor
+    compare_t compare;
+    // picks the height of new towers, see skiplist_level.hpp
+    level_t levels;
+
+    void _reset() {
+        levels_ = 0;
+        size_ = 0;
+        blocks_ = 0;
+        last = nullptr;
+    }
+
+    // forward pointers leaving a block. nullptr stands in for the header
+    block_t **_links(block_t *blk) { return blk ? blk->next : key; }
+
+    int _random_height() {
+        int height = levels(rng_), limit = level_t::level_limit(blocks_);
+        return height < limit ? height : limit;
+    }
+
+    // last block starting at or before value on every level, nullptr for
+    // the header. returns that block at level 0
+    block_t *_upper_path(const val_type &value, block_t **history);
+    // last block starting before value, nullptr if there is none
+    block_t *_lower_block(const val_type &value) const;
+    // predecessors of a block that is in the list, it must not be empty
+    void _path_to(block_t *blk, block_t **history);
+
+    // a new empty block linked in right after history at level 0
+    block_t *_new_block(block_t **history);
+    // unlink a block from every level and free it
+    void _remove_block(block_t *blk, block_t **history);
+    // move the upper half of a full block into a new one after it.
+    // history must be the upper path of an element of the block
+    block_t *_split(block_t *blk, block_t **history);
+    // move every element of from to the end of to
+    void _append(block_t *to, block_t *from);
+    // index of the first element greater than value in a block
+    int _upper_index(const block_t *blk, const val_type &value) const {
+        return int(std::upper_bound(blk->vals(), blk->vals() + blk->count, value, compare)
+                   - blk->vals());
+    }
+
+    // copy the blocks of other, appending each to the levels it spans
+    void _copy_blocks(const unrolled_skiplist &other);
+
+public:
+    template<bool reversal = false>
+    class cake_iterator;
+
+    using const_iterator = cake_iterator<>;
+    using iterator = const_iterator;
+    using const_reverse_iterator = cake_iterator<true>;
+    using reverse_iterator = const_reverse_iterator;
+
+    unrolled_skiplist() { _reset(); }
+
+    // every block comes out of alloc
+    explicit unrolled_skiplist(const alloc_t &alloc) : pool_(alloc) { _reset(); }
+
+    template<typename InputIterator>
+    unrolled_skiplist(InputIterator first, InputIterator last, const alloc_t &alloc = alloc_t())
+    : unrolled_skiplist(alloc) {
+        while(first != last) {
+            insert(*first);
+            ++first;
+        }
+    }
+
+    unrolled_skiplist(std::initializer_list<val_type> l, const alloc_t &alloc = alloc_t())
+    : unrolled_skiplist(l.begin(), l.end(), alloc) {}
+
+    unrolled_skiplist(const unrolled_skiplist &other)
+    : unrolled_skiplist(other, alloc_traits::select_on_container_copy_construction(
+                                   other.get_allocator())) {}
+
+    unrolled_skiplist(const unrolled_skiplist &other, const alloc_t &alloc)
+    : pool_(alloc) {
+        _reset();
+        _copy_blocks(other);
+    }
+
+    unrolled_skiplist(unrolled_skiplist &&other)
+    : levels_(other.levels_), size_(other.size_), blocks_(other.blocks_),
+      last(other.last), pool_(std::move(other.pool_)), rng_(other.rng_) {
+        for(int i=0; i<levels_; i++)
+            key[i] = other.key[i];
+        other._reset();
+    }
+
+    ~unrolled_skiplist() { clear(); }
+
+    unrolled_skiplist &operator=(const unrolled_skiplist &rhs) {
+        if(this == &rhs)
+            return *this;
+        clear();
+        _copy_blocks(rhs);
+        return *this;
+    }
+
+    unrolled_skiplist &operator=(unrolled_skiplist &&rhs) {
+        if(this == &rhs)
+            return *this;
+        clear();
+        // blocks can only change hands if our allocator can free them
+        if(!alloc_traits::propagate_on_container_move_assignment::value
+           && get_allocator() != rhs.get_allocator()) {
+            _copy_blocks(rhs);
+            rhs.clear();
+            return *this;
+        }
+        pool_ = std::move(rhs.pool_);
+        for(int i=0; i<rhs.levels_; i++)
+            key[i] = rhs.key[i];
+        levels_ = rhs.levels_;
+        size_ = rhs.size_;
+        blocks_ = rhs.blocks_;
+        last = rhs.last;
+        rhs._reset();
+        return *this;
+    }
+
+    // drop every element, giving the slabs back
+    void clear() {
+        block_t *blk = levels_ ? key[0] : nullptr, *tmp;
+        while(blk) {
+            tmp = blk->next[0];
+            if(pool_.from_heap(blk->height))
+                block_t::destroy(pool_, blk);
+            else
+                blk->~block_t();
+            blk = tmp;
+        }
+        pool_.release();
+        _reset();
+    }
+
+    void insert(const val_type &value);
+    // removes the most recently inserted of the elements equal to value
+    void erase(const val_type &value);
+    iterator erase(iterator it);
+    // the first of the elements equal to value
+    iterator find(const val_type &value) const;
+
+    int count(const val_type &value) const {
+        int found = 0;
+        for(iterator it = find(value); it != end() && !compare(value, *it); ++it)
+            ++found;
+        return found;
+    }
+    int size() const { return size_; }
+    alloc_t get_allocator() const { return alloc_t(pool_.get_allocator()); }
+    // slabs and free blocks held by the pool
+    SLPoolStats pool_stats() const { return pool_.stats(); }
+
+    iterator begin() const { return iterator(this, levels_ ? key[0] : nullptr, 0); }
+    iterator end() const { return iterator(this, nullptr, 0); }
+    reverse_iterator rbegin() const { return reverse_iterator(this, last, last ? last->count - 1 : 0); }
+    reverse_iterator rend() const { return reverse_iterator(this, nullptr, 0); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+    const_reverse_iterator crbegin() const { return rbegin(); }
+    const_reverse_iterator crend() const { return rend(); }
+
+private:
+    // remove an element, merging blocks that got too empty.
+    // returns where the element after it ended up
+    iterator _erase_at(block_t *blk, int pos);
+};
+
+// Iterator is a block and a position in it, nullptr for end().
+// Moving within a block is just an index, so scans read the
+// elements of a block one after the other
+template<
+    typename val_type,
+    typename compare_t,
+    typename level_t,
+    typename alloc_t,
+    int block_size
+>
+template<bool reversal>
+class unrolled_skiplist<val_type, compare_t, level_t, alloc_t, block_size>::cake_iterator {
+private:
+    const unrolled_skiplist *list_;
+    const block_t *blk_;
+    int pos_;
+
+    friend class unrolled_skiplist;
+
+    // stepping off either end gives nullptr,
+    // and stepping back from there re-enters the list
+    void _forward() {
+        if(!blk_)
+            blk_ = list_->levels_ ? list_->key[0] : nullptr;
+        else if(++pos_ == blk_->count) {
+            blk_ = blk_->next[0];
+            pos_ = 0;
+        }
+    }
+    void _backward() {
+        if(!blk_)
+            blk_ = list_->last;
+        else if(pos_) {
+            --pos_;
+            return;
+        }
+        else
+            blk_ = blk_->back;
+        pos_ = blk_ ? blk_->count - 1 : 0;
+    }
+
+public:
+    using difference_type = std::ptrdiff_t;
+    using value_type = val_type;
+    using pointer = const val_type*;
+    using reference = const val_type&;
+    using iterator_category = std::bidirectional_iterator_tag;
+
+    cake_iterator(const unrolled_skiplist *list, const block_t *blk, int pos)
+    : list_(list), blk_(blk), pos_(pos) {}
+
+    bool operator==(const cake_iterator &rhs) const { return blk_ == rhs.blk_ && pos_ == rhs.pos_; }
+    bool operator!=(const cake_iterator &rhs) const { return !(*this == rhs); }
+
+    const val_type &operator*() const { return blk_->vals()[pos_]; }
+    const val_type *operator->() const { return blk_->vals() + pos_; }
+
+    cake_iterator &operator++() {
+        if(reversal)
+            _backward();
+        else
+            _forward();
+        return *this;
+    }
+    cake_iterator operator++(int) {
+        cake_iterator temp(*this);
+        ++*this;
+        return temp;
+    }
+    cake_iterator &operator--() {
+        if(reversal)
+            _forward();
+        else
+            _backward();
+        return *this;
+    }
+    cake_iterator operator--(int) {
+        cake_iterator temp(*this);
+        --*this;
+        return temp;
+    }
+};
+
+
+/*
+================================================================================
+=================== NOTE! THE PART BELOW IS FROM THE CPP FILE ==================
+================================================================================
+*/
+
+template<typename T, typename X, typename L, typename A, int B>
+SLBlock<T, B> *unrolled_skiplist<T, X, L, A, B>::_upper_path(const T &value, SLBlock<T, B> **history) {
+    SLBlock<T, B> *follow = nullptr, **links = key;
+    for(int level = levels_ - 1; level >= 0; --level) {
+        while(links[level] && !compare(value, links[level]->vals()[0])) {
+            follow = links[level];
+            links = follow->next;
+        }
+        history[level] = follow;
+    }
+    return follow;
+}
+
+template<typename T, typename X, typename L, typename A, int B>
+SLBlock<T, B> *unrolled_skiplist<T, X, L, A, B>::_lower_block(const T &value) const {
+    SLBlock<T, B> *follow = nullptr;
+    SLBlock<T, B> *const *links = key;
+    for(int level = levels_ - 1; level >= 0; --level) {
+        while(links[level] && compare(links[level]->vals()[0], value)) {
+            follow = links[level];
+            links = follow->next;
+        }
+    }
+    return follow;
+}
+
+template<typename T, typename X, typename L, typename A, int B>
+void unrolled_skiplist<T, X, L, A, B>::_path_to(SLBlock<T, B> *blk, SLBlock<T, B> **history) {
+    const T &first = blk->vals()[0];
+    SLBlock<T, B> *follow = nullptr, **links = key;
+    for(int level = levels_ - 1; level >= 0; --level) {
+        while(links[level] && compare(links[level]->vals()[0], first)) {
+            follow = links[level];
+            links = follow->next;
+        }
+        history[level] = follow;
+    }
+    // blocks starting with the same element as blk may still come before
+    // it. that takes more than a block of equal elements, walk past them
+    for(SLBlock<T, B> *at = _links(history[0])[0]; at != blk; at = at->next[0])
+        for(int level = 0; level < at->height; ++level)
+            history[level] = at;
+}
+
+template<typename T, typename X, typename L, typename A, int B>
+SLBlock<T, B> *unrolled_skiplist<T, X, L, A, B>::_new_block(SLBlock<T, B> **history) {
+    ++blocks_;
+    SLBlock<T, B> *blk = SLBlock<T, B>::create(pool_, _random_height());
+    while(levels_ < blk->height) {
+        key[levels_] = nullptr;
+        history[levels_++] = nullptr;
+    }
+    for(int level = 0; level < blk->height; ++level) {
+        SLBlock<T, B> **links = _links(history[level]);
+        blk->next[level] = links[level];
+        links[level] = blk;
+    }
+    blk->back = history[0];
+    if(blk->next[0])
+        blk->next[0]->back = blk;
+    else
+        last = blk;
+    return blk;
+}
+
+template<typename T, typename X, typename L, typename A, int B>
+void unrolled_skiplist<T, X, L, A, B>::_remove_block(SLBlock<T, B> *blk, SLBlock<T, B> **history) {
+    for(int level = 0; level < blk->height; ++level)
+        _links(history[level])[level] = blk->next[level];
+    if(blk->next[0])
+        blk->next[0]->back = blk->back;
+    else
+        last = blk->back;
+    SLBlock<T, B>::destroy(pool_, blk);
+    --blocks_;
+    // Drop levels that became empty
+    while(levels_ && !key[levels_ - 1])
+        --levels_;
+}
+
+template<typename T, typename X, typename L, typename A, int B>
+SLBlock<T, B> *unrolled_skiplist<T, X, L, A, B>::_split(SLBlock<T, B> *blk, SLBlock<T, B> **history) {
+    // the new block goes right after blk, which is on the path
+    // up to its own height
+    for(int level = 0; level < blk->height; ++level)
+        history[level] = blk;
+    SLBlock<T, B> *right = _new_block(history);
+    T *from = blk->vals() + B / 2, *to = right->vals();
+    for(int i = B / 2; i < blk->count; i++, from++, to++) {
+        new(to) T(std::move(*from));
+        from->~T();
+    }
+    right->count = blk->count - B / 2;
+    blk->count = B / 2;
+    return right;
+}
+
+template<typename T, typename X, typename L, typename A, int B>
+void unrolled_skiplist<T, X, L, A, B>::_append(SLBlock<T, B> *to, SLBlock<T, B> *from) {
+    T *src = from->vals(), *dst = to->vals() + to->count;
+    for(int i=0; i<from->count; i++, src++, dst++) {
+        new(dst) T(std::move(*src));
+        src->~T();
+    }
+    to->count += from->count;
+    from->count = 0;
+}
+
+template<typename T, typename X, typename L, typename A, int B>
+typename unrolled_skiplist<T, X, L, A, B>::iterator
+unrolled_skiplist<T, X, L, A, B>::_erase_at(SLBlock<T, B> *blk, int pos) {
+    SLBlock<T, B> *history[L::max_level];
+    --size_;
+    if(blk->count == 1) {
+        // the block goes away with its only element
+        SLBlock<T, B> *after = blk->next[0];
+        _path_to(blk, history);
+        _remove_block(blk, history);
+        return iterator(this, after, 0);
+    }
+
+    T *vals = blk->vals();
+    std::move(vals + pos + 1, vals + blk->count, vals + pos);
+    vals[--blk->count].~T();
+
+    if(blk->count < B / 4) {
+        SLBlock<T, B> *right = blk->next[0], *left = blk->back;
+        if(right && blk->count + right->count <= B) {
+            _path_to(right, history);
+            _append(blk, right);
+            _remove_block(right, history);
+        }
+        else if(left && left->count + blk->count <= B) {
+            _path_to(blk, history);
+            pos += left->count;
+            _append(left, blk);
+            _remove_block(blk, history);
+            blk = left;
+        }
+    }
+    if(pos == blk->count)
+        return iterator(this, blk->next[0], 0);
+    return iterator(this, blk, pos);
+}
+
+template<typename T, typename X, typename L, typename A, int B>
+void unrolled_skiplist<T, X, L, A, B>::_copy_blocks(const unrolled_skiplist &other) {
+    if(!other.levels_)
+        return;
+    // the last block built so far at every level, nullptr is the header
+    SLBlock<T, B> *tails[L::max_level];
+    for(int i=0; i<other.levels_; i++)
+        tails[i] = key[i] = nullptr;
+    levels_ = other.levels_;
+    for(const SLBlock<T, B> *from = other.key[0]; from; from = from->next[0]) {
+        SLBlock<T, B> *blk = SLBlock<T, B>::create(pool_, from->height);
+        for(; blk->count < from->count; ++blk->count)
+            new(blk->vals() + blk->count) T(from->vals()[blk->count]);
+        blk->back = tails[0];
+        for(int i=0; i<blk->height; i++) {
+            _links(tails[i])[i] = blk;
+            tails[i] = blk;
+        }
+    }
+    last = tails[0];
+    size_ = other.size_;
+    blocks_ = other.blocks_;
+}
+
+template<typename T, typename X, typename L, typename A, int B>
+// Equal elements keep their insertion order
+void unrolled_skiplist<T, X, L, A, B>::insert(const T &value) {
+    SLBlock<T, B> *history[L::max_level];
+    // the last block starting at or before value takes it,
+    // right after the elements equal to it
+    SLBlock<T, B> *blk = _upper_path(value, history);
+    if(!blk) {
+        // smaller than everything, goes in front of the first block
+        blk = levels_ ? key[0] : _new_block(history);
+    }
+    int pos = _upper_index(blk, value);
+    if(blk->count == B) {
+        SLBlock<T, B> *right = _split(blk, history);
+        if(pos > blk->count) {
+            pos -= blk->count;
+            blk = right;
+        }
+    }
+
+    T *vals = blk->vals();
+    if(pos == blk->count)
+        new(vals + pos) T(value);
+    else {
+        new(vals + blk->count) T(std::move(vals[blk->count - 1]));
+        std::move_backward(vals + pos, vals + blk->count - 1, vals + blk->count);
+        vals[pos] = value;
+    }
+    ++blk->count;
+    ++size_;
+}
+
+template<typename T, typename X, typename L, typename A, int B>
+// Cannot assume element exists
+void unrolled_skiplist<T, X, L, A, B>::erase(const T &value) {
+    SLBlock<T, B> *history[L::max_level];
+    // blocks after this one start past value,
+    // so the last element equal to value is in here
+    SLBlock<T, B> *blk = _upper_path(value, history);
+    if(!blk)
+        return;
+    int pos = _upper_index(blk, value) - 1;
+    if(compare(blk->vals()[pos], value))
+        return;
+    _erase_at(blk, pos);
+}
+
+template<typename T, typename X, typename L, typename A, int B>
+// Assume that iterator is valid
+// After erasing, move on to the next element
+typename unrolled_skiplist<T, X, L, A, B>::iterator
+unrolled_skiplist<T, X, L, A, B>::erase(typename unrolled_skiplist<T, X, L, A, B>::iterator it) {
+    return _erase_at(const_cast<SLBlock<T, B>*>(it.blk_), it.pos_);
+}
+
+template<typename T, typename X, typename L, typename A, int B>
+typename unrolled_skiplist<T, X, L, A, B>::iterator
+unrolled_skiplist<T, X, L, A, B>::find(const T &value) const {
+    if(!levels_)
+        return end();
+    // the first element not less than value is in the last block
+    // starting before value, or first thing in the block after it
+    const SLBlock<T, B> *blk = _lower_block(value);
+    int pos = 0;
+    if(!blk)
+        blk = key[0];
+    else
+        pos = int(std::lower_bound(blk->vals(), blk->vals() + blk->count, value, compare)
+                  - blk->vals());
+    if(pos == blk->count) {
+        blk = blk->next[0];
+        pos = 0;
+    }
+    if(!blk || compare(value, blk->vals()[pos]))
+        return end();
+    return iterator(this, blk, pos);
+}
+// End of cpp file
+
+#endif
+// End of header file